@@ -0,0 +1,35 @@
+﻿#include "TIRevertScriptCommand.h"
+
+
+#include "FGPlayerController.h"
+#include "Command/CommandSender.h"
+#include "TweakIt/Lua/Scripting/TIScriptOrchestrator.h"
+
+ATIRevertScriptCommand::ATIRevertScriptCommand()
+{
+	CommandName = TEXT("revertscript");
+	Usage = TEXT("/revertscript [Script Name] - Undoes the property changes of a script's last run");
+	MinNumberOfArguments = 1;
+	bOnlyUsableByPlayer = false;
+	Aliases.Add(TEXT("rvs"));
+}
+
+EExecutionStatus ATIRevertScriptCommand::ExecuteCommand_Implementation(
+	UCommandSender* Sender,
+	const TArray<FString>& Arguments,
+	const FString& Label
+)
+{
+	if (!Sender->GetPlayer()->HasAuthority())
+	{
+		Sender->SendChatMessage("You do not have the sufficient rights to do this.");
+		return EExecutionStatus::INSUFFICIENT_PERMISSIONS;
+	}
+	if (!FTIScriptOrchestrator::Get()->RevertScript(Arguments[0]))
+	{
+		Sender->SendChatMessage("This script has no changes to revert");
+		return EExecutionStatus::UNCOMPLETED;
+	}
+	Sender->SendChatMessage("Success !");
+	return EExecutionStatus::COMPLETED;
+}
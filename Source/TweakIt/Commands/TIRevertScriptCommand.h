@@ -0,0 +1,16 @@
+﻿#pragma once
+#include "command/ChatCommandLibrary.h"
+#include "TIRevertScriptCommand.generated.h"
+
+UCLASS()
+class ATIRevertScriptCommand : public AChatCommandInstance
+{
+	GENERATED_BODY()
+public:
+	ATIRevertScriptCommand();
+	virtual EExecutionStatus ExecuteCommand_Implementation(
+		UCommandSender* Sender,
+		const TArray<FString>& Arguments,
+		const FString& Label
+	) override;
+};
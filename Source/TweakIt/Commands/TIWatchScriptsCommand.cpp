@@ -0,0 +1,32 @@
+﻿#include "TIWatchScriptsCommand.h"
+
+
+#include "FGPlayerController.h"
+#include "Command/CommandSender.h"
+#include "TweakIt/Lua/Scripting/TIScriptOrchestrator.h"
+
+ATIWatchScriptsCommand::ATIWatchScriptsCommand()
+{
+	CommandName = TEXT("watchscripts");
+	Usage = TEXT("/watchscripts [on|off] - Reruns scripts when their file changes. Toggles without an argument");
+	bOnlyUsableByPlayer = false;
+	Aliases.Add(TEXT("ws"));
+}
+
+EExecutionStatus ATIWatchScriptsCommand::ExecuteCommand_Implementation(
+	UCommandSender* Sender,
+	const TArray<FString>& Arguments,
+	const FString& Label
+)
+{
+	if (!Sender->GetPlayer()->HasAuthority())
+	{
+		Sender->SendChatMessage("You do not have the sufficient rights to do this.");
+		return EExecutionStatus::INSUFFICIENT_PERMISSIONS;
+	}
+	FTIScriptOrchestrator* Orchestrator = FTIScriptOrchestrator::Get();
+	const bool Watch = Arguments.Num() > 0 ? Arguments[0] == "on" : !Orchestrator->IsWatching();
+	Orchestrator->SetWatching(Watch);
+	Sender->SendChatMessage(Watch ? "Watching the scripts for changes" : "Stopped watching the scripts");
+	return EExecutionStatus::COMPLETED;
+}
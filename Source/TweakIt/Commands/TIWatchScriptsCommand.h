@@ -0,0 +1,16 @@
+﻿#pragma once
+#include "command/ChatCommandLibrary.h"
+#include "TIWatchScriptsCommand.generated.h"
+
+UCLASS()
+class ATIWatchScriptsCommand : public AChatCommandInstance
+{
+	GENERATED_BODY()
+public:
+	ATIWatchScriptsCommand();
+	virtual EExecutionStatus ExecuteCommand_Implementation(
+		UCommandSender* Sender,
+		const TArray<FString>& Arguments,
+		const FString& Label
+	) override;
+};
@@ -0,0 +1,90 @@
+#include "TIChangeJournal.h"
+
+#include "TweakIt/Logging/FTILog.h"
+
+FTIChangeJournal::~FTIChangeJournal()
+{
+	Clear();
+}
+
+void FTIChangeJournal::Record(UObject* Object, FProperty* Property)
+{
+	const TPair<UObject*, FProperty*> Key(Object, Property);
+	if (FEntry* Existing = Entries.Find(Key))
+	{
+		// The address may belong to an object that was collected since
+		if (Existing->Object.Get() == Object)
+		{
+			return;
+		}
+		Free(*Existing);
+		Entries.Remove(Key);
+	}
+	if (Previous.IsValid())
+	{
+		FEntry Inherited;
+		if (Previous->Entries.RemoveAndCopyValue(Key, Inherited))
+		{
+			if (Inherited.Object.Get() == Object)
+			{
+				Entries.Add(Key, Inherited);
+				return;
+			}
+			Free(Inherited);
+		}
+	}
+	FEntry Entry;
+	Entry.Object = Object;
+	Entry.Property = Property;
+	Entry.Owner = Property->GetOwnerStruct();
+	Entry.Original = static_cast<uint8*>(FMemory::Malloc(Property->GetSize(), Property->GetMinAlignment()));
+	Property->InitializeValue(Entry.Original);
+	Property->CopyCompleteValue(Entry.Original, Property->ContainerPtrToValuePtr<void>(Object));
+	Entries.Add(Key, Entry);
+}
+
+void FTIChangeJournal::Finish()
+{
+	if (Previous.IsValid())
+	{
+		LOGFV("Reverting %d changes the new run didn't make again", Previous->Num())
+		Previous->Revert();
+		Previous.Reset();
+	}
+}
+
+void FTIChangeJournal::Revert()
+{
+	for (auto& Entry : Entries)
+	{
+		Restore(Entry.Value);
+	}
+	Clear();
+	Finish();
+}
+
+void FTIChangeJournal::Restore(FEntry& Entry)
+{
+	if (UObject* Object = Entry.Object.Get())
+	{
+		Entry.Property->CopyCompleteValue(Entry.Property->ContainerPtrToValuePtr<void>(Object), Entry.Original);
+	}
+}
+
+void FTIChangeJournal::Free(FEntry& Entry)
+{
+	if (Entry.Owner.IsValid())
+	{
+		Entry.Property->DestroyValue(Entry.Original);
+	}
+	FMemory::Free(Entry.Original);
+}
+
+void FTIChangeJournal::Clear()
+{
+	for (auto& Entry : Entries)
+	{
+		Free(Entry.Value);
+	}
+	Entries.Empty();
+}
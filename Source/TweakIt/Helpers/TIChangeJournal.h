@@ -0,0 +1,41 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// The original values of the properties a script run wrote, so the run can be undone.
+// When a script is run again, its new journal takes over the originals of the previous run. Once the new run
+// completes, only what it didn't write again gets reverted
+class FTIChangeJournal
+{
+public:
+	FTIChangeJournal() = default;
+	~FTIChangeJournal();
+	UE_NONCOPYABLE(FTIChangeJournal)
+
+	// Call before writing the property. Only the first write of a property of an object is snapshotted
+	void Record(UObject* Object, FProperty* Property);
+	// Reverts what the previous run changed and this one didn't
+	void Finish();
+	// Reverts everything, including what the previous run changed
+	void Revert();
+
+	int32 Num() const { return Entries.Num(); }
+
+	TSharedPtr<FTIChangeJournal> Previous;
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<UObject> Object;
+		FProperty* Property;
+		// Properties are freed with the struct declaring them
+		TWeakObjectPtr<UStruct> Owner;
+		// The value itself, initialized as the property's type
+		uint8* Original;
+	};
+
+	static void Restore(FEntry& Entry);
+	static void Free(FEntry& Entry);
+	void Clear();
+
+	TMap<TPair<UObject*, FProperty*>, FEntry> Entries;
+};
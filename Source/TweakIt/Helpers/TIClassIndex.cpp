@@ -0,0 +1,128 @@
+#include "TIClassIndex.h"
+
+#include "AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/UserDefinedStruct.h"
+#include "TweakIt/Logging/FTILog.h"
+
+FTIClassIndex::FNameIndex FTIClassIndex::Classes;
+FTIClassIndex::FNameIndex FTIClassIndex::Structs;
+bool FTIClassIndex::Built = false;
+bool FTIClassIndex::Bound = false;
+
+UClass* FTIClassIndex::FindClass(const FString& Name, const FString& Package)
+{
+	EnsureBuilt();
+	return Find<UClass>(Classes, Name, Package);
+}
+
+UScriptStruct* FTIClassIndex::FindStruct(const FString& Name, const FString& Package)
+{
+	EnsureBuilt();
+	return Find<UScriptStruct>(Structs, Name, Package);
+}
+
+void FTIClassIndex::Invalidate()
+{
+	Built = false;
+	Classes = {};
+	Structs = {};
+}
+
+template <class T>
+T* FTIClassIndex::Find(FNameIndex& Index, const FString& Name, const FString& Package)
+{
+	// Every indexed name is already an FName
+	const FName Key = FName(*Name, FNAME_Find);
+	if (Key.IsNone() || Index.Missing.Contains(Key))
+	{
+		return nullptr;
+	}
+	if (TArray<FString>* Paths = Index.Paths.Find(Key))
+	{
+		const FString Native = "/Script/" + Package + "." + Name;
+		// A copy, loading can invalidate the index and free Paths
+		const FString Path = Paths->Contains(Native) ? Native : (*Paths)[0];
+		T* Found = FindObject<T>(nullptr, *Path);
+		if (!Found)
+		{
+			LOGFV("Loading %s", *Path)
+			Found = LoadObject<T>(nullptr, *Path);
+		}
+		if (Found)
+		{
+			return Found;
+		}
+	}
+	Index.Missing.Add(Key);
+	return nullptr;
+}
+
+void FTIClassIndex::EnsureBuilt()
+{
+	if (Built)
+	{
+		return;
+	}
+	BindInvalidation();
+	const double Start = FPlatformTime::Seconds();
+	auto AddPath = [](FNameIndex& Index, FName Name, FString Path)
+	{
+		Index.Paths.FindOrAdd(Name).AddUnique(MoveTemp(Path));
+	};
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		AddPath(Classes, It->GetFName(), It->GetPathName());
+	}
+	for (TObjectIterator<UScriptStruct> It; It; ++It)
+	{
+		AddPath(Structs, It->GetFName(), It->GetPathName());
+	}
+
+	IAssetRegistry& Registry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	TArray<FAssetData> Assets;
+	Registry.GetAssetsByClass(UBlueprint::StaticClass()->GetFName(), Assets, true);
+	for (const FAssetData& Asset : Assets)
+	{
+		FString GeneratedClass;
+		if (Asset.GetTagValue(FBlueprintTags::GeneratedClassPath, GeneratedClass))
+		{
+			const FString Path = FPackageName::ExportTextPathToObjectPath(GeneratedClass);
+			AddPath(Classes, FName(*FPackageName::ObjectPathToObjectName(Path)), Path);
+		}
+	}
+	// Cooked registries can list the generated classes themselves
+	Assets.Reset();
+	Registry.GetAssetsByClass(UBlueprintGeneratedClass::StaticClass()->GetFName(), Assets, true);
+	for (const FAssetData& Asset : Assets)
+	{
+		AddPath(Classes, Asset.AssetName, Asset.ObjectPath.ToString());
+	}
+	Assets.Reset();
+	Registry.GetAssetsByClass(UUserDefinedStruct::StaticClass()->GetFName(), Assets, true);
+	for (const FAssetData& Asset : Assets)
+	{
+		AddPath(Structs, Asset.AssetName, Asset.ObjectPath.ToString());
+	}
+
+	Built = true;
+	LOGFV("Indexed %d class names and %d struct names in %.2fms", Classes.Paths.Num(), Structs.Paths.Num(),
+	      (FPlatformTime::Seconds() - Start) * 1000)
+}
+
+void FTIClassIndex::BindInvalidation()
+{
+	if (Bound)
+	{
+		return;
+	}
+	Bound = true;
+	FModuleManager::Get().OnModulesChanged().AddLambda([](FName, EModuleChangeReason) { Invalidate(); });
+	IAssetRegistry& Registry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	Registry.OnAssetAdded().AddLambda([](const FAssetData&) { Invalidate(); });
+	Registry.OnAssetRemoved().AddLambda([](const FAssetData&) { Invalidate(); });
+	Registry.OnAssetRenamed().AddLambda([](const FAssetData&, const FString&) { Invalidate(); });
+	// The registry may still be scanning when the first script runs
+	Registry.OnFilesLoaded().AddStatic(&FTIClassIndex::Invalidate);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Short names of every class and struct, loaded or not, mapped to their paths so scripts don't have to know them.
+// Built on first use from the loaded types and the asset registry, and rebuilt after modules or assets change.
+// Names that weren't found are remembered until then
+class FTIClassIndex
+{
+public:
+	// Package picks between types sharing a name, its native type wins
+	static UClass* FindClass(const FString& Name, const FString& Package);
+	static UScriptStruct* FindStruct(const FString& Name, const FString& Package);
+
+	static void Invalidate();
+private:
+	struct FNameIndex
+	{
+		TMap<FName, TArray<FString>> Paths;
+		TSet<FName> Missing;
+	};
+
+	template <class T>
+	static T* Find(FNameIndex& Index, const FString& Name, const FString& Package);
+	static void EnsureBuilt();
+	static void BindInvalidation();
+
+	static FNameIndex Classes;
+	static FNameIndex Structs;
+	static bool Built;
+	static bool Bound;
+};
@@ -0,0 +1,100 @@
+#include "TIDefaultValuePropagator.h"
+
+#include "TweakIt/Logging/FTILog.h"
+#include "TweakIt/Lua/Lua.h"
+#include "UObject/UObjectHash.h"
+
+void FTIDefaultValuePropagator::AddChange(lua_State* L, UClass* Class, FProperty* Property, int Index)
+{
+	// Converted once, everything else gets a copy
+	if (Journal)
+	{
+		Journal->Record(Class->GetDefaultObject(), Property);
+	}
+	FTILua::LuaToProperty(L, Property, Class->GetDefaultObject(), Index);
+	// Changes are kept in the order of their last write
+	if (Recorded.Contains({Class, Property}))
+	{
+		Changes.RemoveAll([Class, Property](const FChange& Change)
+		{
+			return Change.Class == Class && Change.Property == Property;
+		});
+	}
+	else
+	{
+		Recorded.Add({Class, Property});
+	}
+	Changes.Add({Class, Property});
+}
+
+void FTIDefaultValuePropagator::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (FChange& Change : Changes)
+	{
+		Collector.AddReferencedObject(Change.Class);
+	}
+}
+
+FTIPropagationStats FTIDefaultValuePropagator::Propagate()
+{
+	FTIPropagationStats Stats;
+	Stats.Changes = Changes.Num();
+	const double Start = FPlatformTime::Seconds();
+
+	// The change each property of each class takes its value from, so a batch ends up like the same writes made one
+	// by one: a class's own change wins, otherwise the last change of its parents in write order. Default objects
+	// with their own change are never overwritten
+	TMap<UClass*, TMap<FProperty*, int32>> ClassChanges;
+	TSet<UClass*> Roots;
+	for (int32 i = 0; i < Changes.Num(); i++)
+	{
+		UClass* Class = Changes[i].Class;
+		FProperty* Property = Changes[i].Property;
+		Roots.Add(Class);
+		TArray<UClass*> Classes = {Class};
+		GetDerivedClasses(Class, Classes);
+		for (UClass* Derived : Classes)
+		{
+			TMap<FProperty*, int32>& Sources = ClassChanges.FindOrAdd(Derived);
+			const int32* Existing = Sources.Find(Property);
+			if (Derived == Class || !Existing || Changes[*Existing].Class != Derived)
+			{
+				Sources.Add(Property, i);
+			}
+		}
+	}
+
+	auto Apply = [&](UObject* Object)
+	{
+		TMap<FProperty*, int32>* Found = ClassChanges.Find(Object->GetClass());
+		if (!Found)
+		{
+			return;
+		}
+		Stats.Objects++;
+		for (const TPair<FProperty*, int32>& PropertyChange : *Found)
+		{
+			const int32 Change = PropertyChange.Value;
+			UObject* Source = Changes[Change].Class->GetDefaultObject();
+			if (Object != Source)
+			{
+				if (Journal)
+				{
+					Journal->Record(Object, Changes[Change].Property);
+				}
+				Changes[Change].Property->CopyCompleteValue_InContainer(Object, Source);
+				Stats.Properties++;
+			}
+		}
+	};
+	// A single class only needs its own objects, otherwise it's one pass over everything
+	UClass* Searched = Roots.Num() == 1 ? *Roots.CreateConstIterator() : UObject::StaticClass();
+	ForEachObjectOfClass(Searched, Apply, true, RF_NoFlags);
+
+	Stats.Milliseconds = (FPlatformTime::Seconds() - Start) * 1000;
+	LOGFV("Propagated %d changes to %d objects (%d properties) in %.2fms", Changes.Num(), Stats.Objects,
+	      Stats.Properties, Stats.Milliseconds)
+	Changes.Empty();
+	Recorded.Empty();
+	return Stats;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "TIChangeJournal.h"
+#include "TweakIt/Lua/lib/lua.hpp"
+
+struct FTIPropagationStats
+{
+	int32 Changes = 0;
+	int32 Objects = 0;
+	int32 Properties = 0;
+	double Milliseconds = 0;
+};
+
+// Changes default values and copies them to every live object of the classes, visiting each object once
+// however many classes and properties were changed.
+// A change applies to the class, its subclasses and all their objects, default objects included
+class FTIDefaultValuePropagator
+{
+public:
+	// Converts the Lua value at Index into the class's default object. Changing the same default twice propagates once
+	void AddChange(lua_State* L, UClass* Class, FProperty* Property, int Index);
+	bool HasChanges() const { return Changes.Num() > 0; }
+
+	FTIPropagationStats Propagate();
+
+	// Keeps the changed classes alive while changes wait to be propagated
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+	// Receives every write, default objects included
+	FTIChangeJournal* Journal = nullptr;
+
+private:
+	struct FChange
+	{
+		UClass* Class;
+		FProperty* Property;
+	};
+
+	TArray<FChange> Changes;
+	TSet<TPair<UClass*, FProperty*>> Recorded;
+};
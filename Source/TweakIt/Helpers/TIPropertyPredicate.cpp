@@ -0,0 +1,138 @@
+#include "TIPropertyPredicate.h"
+
+#include "TweakIt/Lua/PropertyMarshaller.h"
+
+namespace
+{
+	struct FConversion
+	{
+		FProperty* Property;
+		void* Value;
+	};
+}
+
+FTIPropertyPredicate::FTIPropertyPredicate(TArray<FProperty*> Path, ETIComparison Comparison, void* Value, double Number)
+	: Path(MoveTemp(Path)), Comparison(Comparison), Value(Value), Number(Number)
+{
+}
+
+TUniquePtr<FTIPropertyPredicate> FTIPropertyPredicate::Make(TArray<FProperty*> Path, ETIComparison Comparison,
+                                                           lua_State* L, int Index)
+{
+	FProperty* Property = Path.Last();
+	Index = lua_absindex(L, Index);
+	if (Comparison == ETIComparison::Equal || Comparison == ETIComparison::NotEqual)
+	{
+		void* Value = FMemory::Malloc(Property->GetSize(), Property->GetMinAlignment());
+		Property->InitializeValue(Value);
+		// Converted protected, so the value can be freed if it fails. It keeps its index for argument errors
+		FConversion Conversion = {Property, Value};
+		luaL_checkstack(L, Index + 1, nullptr);
+		lua_pushcfunction(L, ConvertValue);
+		lua_pushlightuserdata(L, &Conversion);
+		for (int i = 2; i < Index; i++)
+		{
+			lua_pushnil(L);
+		}
+		lua_pushvalue(L, Index);
+		if (lua_pcall(L, FMath::Max(Index, 2), 0, 0) != LUA_OK)
+		{
+			Property->DestroyValue(Value);
+			FMemory::Free(Value);
+			return nullptr;
+		}
+		return TUniquePtr<FTIPropertyPredicate>(new FTIPropertyPredicate(MoveTemp(Path), Comparison, Value, 0));
+	}
+	if (!Property->IsA<FNumericProperty>())
+	{
+		lua_pushfstring(L, "%s isn't a number and can't be ordered", TCHAR_TO_UTF8(*Property->GetName()));
+		return nullptr;
+	}
+	if (!lua_isnumber(L, Index))
+	{
+		lua_pushfstring(L, "%s can only be ordered against a number, got %s", TCHAR_TO_UTF8(*Property->GetName()),
+		                luaL_typename(L, Index));
+		return nullptr;
+	}
+	const double Number = lua_tonumber(L, Index);
+	return TUniquePtr<FTIPropertyPredicate>(new FTIPropertyPredicate(MoveTemp(Path), Comparison, nullptr, Number));
+}
+
+int FTIPropertyPredicate::ConvertValue(lua_State* L)
+{
+	const FConversion* Conversion = static_cast<FConversion*>(lua_touserdata(L, 1));
+	FTIPropertyMarshaller::FromLua(L, Conversion->Property, Conversion->Value, lua_gettop(L));
+	return 0;
+}
+
+FTIPropertyPredicate::~FTIPropertyPredicate()
+{
+	if (Value)
+	{
+		Path.Last()->DestroyValue(Value);
+		FMemory::Free(Value);
+	}
+}
+
+bool FTIPropertyPredicate::Matches(const UObject* Object) const
+{
+	const void* Container = Object;
+	for (int32 i = 0; i < Path.Num() - 1; i++)
+	{
+		const void* Inner = Path[i]->ContainerPtrToValuePtr<void>(Container);
+		if (const FObjectProperty* ObjectProperty = CastField<FObjectProperty>(Path[i]))
+		{
+			Inner = ObjectProperty->GetObjectPropertyValue(Inner);
+			if (!Inner)
+			{
+				return false;
+			}
+		}
+		Container = Inner;
+	}
+	const FProperty* Property = Path.Last();
+	const void* PropertyValue = Property->ContainerPtrToValuePtr<void>(Container);
+	switch (Comparison)
+	{
+	case ETIComparison::Equal:
+		return Property->Identical(PropertyValue, Value);
+	case ETIComparison::NotEqual:
+		return !Property->Identical(PropertyValue, Value);
+	default:
+		break;
+	}
+	const FNumericProperty* Numeric = static_cast<const FNumericProperty*>(Property);
+	const double Compared = Numeric->IsFloatingPoint()
+		                        ? Numeric->GetFloatingPointPropertyValue(PropertyValue)
+		                        : static_cast<double>(Numeric->GetSignedIntPropertyValue(PropertyValue));
+	switch (Comparison)
+	{
+	case ETIComparison::Less:
+		return Compared < Number;
+	case ETIComparison::LessEqual:
+		return Compared <= Number;
+	case ETIComparison::Greater:
+		return Compared > Number;
+	default:
+		return Compared >= Number;
+	}
+}
+
+bool FTIPropertyPredicate::ParseComparison(const FString& Operator, ETIComparison& OutComparison)
+{
+	static const TMap<FString, ETIComparison> Operators = {
+		{"==", ETIComparison::Equal},
+		{"~=", ETIComparison::NotEqual},
+		{"!=", ETIComparison::NotEqual},
+		{"<", ETIComparison::Less},
+		{"<=", ETIComparison::LessEqual},
+		{">", ETIComparison::Greater},
+		{">=", ETIComparison::GreaterEqual},
+	};
+	if (const ETIComparison* Found = Operators.Find(Operator))
+	{
+		OutComparison = *Found;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "TweakIt/Lua/lib/lua.hpp"
+
+enum class ETIComparison : uint8
+{
+	Equal,
+	NotEqual,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual
+};
+
+// Compares a property of objects against a value converted from Lua once, so objects can be tested without
+// crossing into Lua. Matching only reads the objects and can run on any thread
+class FTIPropertyPredicate
+{
+public:
+	// Path goes from a property of the object to the compared one, through struct and object properties.
+	// Ordering comparisons need a numeric property. Doesn't raise: if the value at Index can't be compared, returns
+	// nullptr with the error message pushed, for the caller to raise once nothing of its own would leak
+	static TUniquePtr<FTIPropertyPredicate> Make(TArray<FProperty*> Path, ETIComparison Comparison, lua_State* L, int Index);
+	~FTIPropertyPredicate();
+	UE_NONCOPYABLE(FTIPropertyPredicate)
+
+	bool Matches(const UObject* Object) const;
+
+	// Accepts ==, ~=, !=, <, <=, > and >=
+	static bool ParseComparison(const FString& Operator, ETIComparison& OutComparison);
+
+private:
+	FTIPropertyPredicate(TArray<FProperty*> Path, ETIComparison Comparison, void* Value, double Number);
+
+	static int ConvertValue(lua_State* L);
+
+	TArray<FProperty*> Path;
+	ETIComparison Comparison;
+	void* Value = nullptr;
+	double Number = 0;
+};
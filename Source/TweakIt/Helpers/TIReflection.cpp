@@ -3,6 +3,8 @@
 #include <functional>
 
 
+#include "TIClassIndex.h"
+#include "TIReflectionCache.h"
 #include "TIUFunctionBinder.h"
 // #include "Editor/KismetCompiler/Public/KismetCompilerMisc.h"
 #include "Engine/SCS_Node.h"
@@ -12,91 +14,83 @@ UClass* FTIReflection::UFunctionOuterBuffer = nullptr;
 
 FProperty* FTIReflection::FindPropertyByName(UStruct* Class, const TCHAR* PropertyName)
 {
-	FString lowered = FString(PropertyName).ToLower();
-	for (FProperty* Property = Class->PropertyLink; Property; Property = Property->PropertyLinkNext)
+	// A name that was never made into an FName can't be the name of a property
+	const FName Name = FName(PropertyName, FNAME_Find);
+	if (!Class || Name.IsNone())
 	{
-		if (Property->GetName().ToLower() == lowered)
-		{
-			return Property;
-		}
+		return nullptr;
 	}
-	return nullptr;
+	return FTIReflectionCache::FindProperty(Class, Name);
 }
 
-UFunction* FTIReflection::FindFunctionByName(UStruct* Class, const TCHAR* PropertyName)
+bool FTIReflection::FindPropertyPath(UStruct* Class, const FString& Path, TArray<FProperty*>& OutPath)
 {
-	FString lowered = FString(PropertyName).ToLower();
-	for (auto Iterator = TFieldIterator<UFunction>(Class); Iterator; ++Iterator)
+	TArray<FString> Names;
+	Path.ParseIntoArray(Names, TEXT("."));
+	OutPath.Reset();
+	UStruct* Current = Class;
+	for (const FString& Name : Names)
 	{
-		if (*Iterator->GetName().ToLower() == lowered)
+		if (!Current)
 		{
-			return *Iterator;
+			return false;
 		}
-	}
-	return nullptr;
-}
-
-UClass* FTIReflection::FindBPUnreliable(FString ClassName)
-{
-	for (TObjectIterator<UBlueprintGeneratedClass> it; it; ++it)
-	{
-		UClass* ItClass = *it;
-		if (ItClass->GetName() == ClassName)
+		FProperty* Property = FindPropertyByName(Current, *Name);
+		if (!Property)
 		{
-			return ItClass;
+			return false;
+		}
+		OutPath.Add(Property);
+		if (FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			Current = StructProperty->Struct;
+		}
+		else if (FObjectProperty* ObjectProperty = CastField<FObjectProperty>(Property))
+		{
+			Current = ObjectProperty->PropertyClass;
+		}
+		else
+		{
+			Current = nullptr;
 		}
 	}
-	LOGF("Was unable to find the BP class \"%s\" by iterating", *ClassName)
-	return nullptr;
+	return OutPath.Num() > 0;
 }
 
-UStruct* FTIReflection::FindStructUnreliable(FString ClassName)
+UFunction* FTIReflection::FindFunctionByName(UStruct* Class, const TCHAR* PropertyName)
 {
-	for (TObjectIterator<UStruct> it; it; ++it)
+	const FName Name = FName(PropertyName, FNAME_Find);
+	if (!Class || Name.IsNone())
 	{
-		UStruct* ItClass = *it;
-		LOG(ItClass->GetFullName())
-		if (ItClass->GetName().ToLower() == ClassName.ToLower())
-		{
-			return ItClass;
-		}
+		return nullptr;
 	}
-	LOGF("Was unable to find the BP class \"%s\" by iterating", *ClassName)
-	return nullptr;
+	return FTIReflectionCache::FindFunction(Class, Name);
 }
 
 UClass* FTIReflection::FindClassByName(FString ClassName, FString Package = "FactoryGame")
 {
-	LOGF("Trying to load %s", *ClassName)
-	UClass* LoadedClass = LoadObject<UClass>(nullptr, *ClassName);
-	if (!LoadedClass->IsValidLowLevel())
+	// Anything that looks like a path is loaded as one, short names go through the index
+	if (ClassName.Contains(TEXT("/")))
 	{
-		LOGF("Trying to load /Script/%s.%s", *Package, *ClassName)
-		LoadedClass = LoadObject<UClass>(nullptr, *("/Script/" + Package + "." + ClassName));
-		if (!LoadedClass->IsValidLowLevel())
-		{
-			LOG("Trying to find the class by iterating")
-			LoadedClass = FindBPUnreliable(ClassName);
-		}
+		LOGFT("Trying to load %s", *ClassName)
+		return LoadObject<UClass>(nullptr, *ClassName);
+	}
+	UClass* Class = FTIClassIndex::FindClass(ClassName, Package);
+	if (!Class)
+	{
+		LOGF("Was unable to find the class \"%s\"", *ClassName)
 	}
-	return LoadedClass;
+	return Class;
 }
 
 UStruct* FTIReflection::FindStructByName(FString ClassName, FString Package = "FactoryGame")
 {
-	LOGF("Trying to load %s", *ClassName)
-	UStruct* LoadedClass = LoadObject<UStruct>(nullptr, *ClassName);
-	if (!LoadedClass->IsValidLowLevel())
+	if (ClassName.Contains(TEXT("/")))
 	{
-		LOGF("Trying to load /Script/%s.%s", *Package, *ClassName)
-		LoadedClass = LoadObject<UStruct>(nullptr, *("/Script/" + Package + "." + ClassName));
-		if (!LoadedClass->IsValidLowLevel())
-		{
-			LOG("Trying to find the class by iterating")
-			LoadedClass = FindStructUnreliable(ClassName);
-		}
+		LOGFT("Trying to load %s", *ClassName)
+		return LoadObject<UStruct>(nullptr, *ClassName);
 	}
-	return LoadedClass;
+	return FTIClassIndex::FindStruct(ClassName, Package);
 }
 
 UActorComponent* FTIReflection::FindDefaultComponentByName(
@@ -236,6 +230,8 @@ UClass* FTIReflection::GenerateUniqueSimpleClass(const TCHAR* PackageName, const
 	ConstructedClassObject->AssembleReferenceTokenStream(true);
 	LOG("linking")
 	ConstructedClassObject->StaticLink();
+	FTIReflectionCache::Invalidate(ConstructedClassObject);
+	FTIClassIndex::Invalidate();
 	//Make sure default class object is initialized and copy the values from parent CDO to handle values set by Blueprints
 	LOG("getting CDO")
 	UObject* CDO = ConstructedClassObject->GetDefaultObject();
@@ -459,18 +455,6 @@ FProperty* FTIReflection::CopyProperty(FFieldVariant Outer, FProperty* Prop)
 	return nullptr;
 }
 
-void FTIReflection::CleanUFunctionParams(UFunction* Function, void* Params)
-{
-	for (FProperty* Prop = Function->PropertyLink; Prop; Prop = Prop->PropertyLinkNext)
-	{
-		if (Prop->HasAnyPropertyFlags(CPF_ReturnParm) || !Prop->HasAllPropertyFlags(CPF_Parm) || !Prop->HasAllPropertyFlags(CPF_ReferenceParm))
-		{
-			continue;
-		}
-		Prop->DestroyValue_InContainer(Params);
-	}
-}
-
 // TODO: Test
 uint8 FTIReflection::GetBoolPropertyBitmask(FBoolProperty* Prop)
 {
@@ -12,11 +12,11 @@ public:
 		const TSubclassOf<UActorComponent> InComponentClass,
 		FString ComponentName
 	);
-	static UClass* FindBPUnreliable(FString ClassName);
-	static UStruct* FindStructUnreliable(FString ClassName);
 	static UClass* FindClassByName(FString ClassName, FString Package);
 	static UStruct* FindStructByName(FString ClassName, FString Package);
 	static FProperty* FindPropertyByName(UStruct* Class, const TCHAR* PropertyName);
+	// Resolves a dot separated path like "Item.Amount", going through struct and object pointer properties
+	static bool FindPropertyPath(UStruct* Class, const FString& Path, TArray<FProperty*>& OutPath);
 	static UFunction* FindFunctionByName(UStruct* Class, const TCHAR* PropertyName);
 
 	static UClass* GenerateUniqueSimpleClass(const TCHAR* PackageName, const TCHAR* ClassName, UClass* ParentClass);
@@ -26,8 +26,6 @@ public:
 	static UFunction* CopyUFunction(UFunction* ToCopy, FString FunctionName, UClass* Outer = nullptr);
 	static FProperty* CopyProperty(FFieldVariant Outer, FProperty* Prop);
 
-	static void CleanUFunctionParams(UFunction* Function, void* Params);
-
 	static uint8 GetBoolPropertyBitmask(FBoolProperty* Prop);
 	static void ReverseChildProperties(FField** Head);
 	template <class T>
@@ -0,0 +1,86 @@
+#include "TIReflectionCache.h"
+
+TMap<UStruct*, FTIStructIndex> FTIReflectionCache::Indices = {};
+FDelegateHandle FTIReflectionCache::PostGarbageCollectHandle;
+uint64 FTIReflectionCache::FunctionHits = 0;
+uint64 FTIReflectionCache::FunctionMisses = 0;
+
+FProperty* FTIReflectionCache::FindProperty(UStruct* Struct, FName Name)
+{
+	FProperty** Property = GetIndex(Struct).Properties.Find(Name);
+	return Property ? *Property : nullptr;
+}
+
+UFunction* FTIReflectionCache::FindFunction(UStruct* Struct, FName Name)
+{
+	FTIStructIndex& Index = GetIndex(Struct);
+	if (UFunction** Function = Index.Functions.Find(Name))
+	{
+		FunctionHits++;
+		return *Function;
+	}
+	FunctionMisses++;
+	UFunction* Found = nullptr;
+	for (TFieldIterator<UFunction> Iterator(Struct); Iterator; ++Iterator)
+	{
+		if (Iterator->GetFName() == Name)
+		{
+			Found = *Iterator;
+			break;
+		}
+	}
+	Index.Functions.Add(Name, Found);
+	return Found;
+}
+
+void FTIReflectionCache::Invalidate(UStruct* Struct)
+{
+	Indices.Remove(Struct);
+}
+
+int32 FTIReflectionCache::Num()
+{
+	return Indices.Num();
+}
+
+FTIStructIndex& FTIReflectionCache::GetIndex(UStruct* Struct)
+{
+	if (!PostGarbageCollectHandle.IsValid())
+	{
+		PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&PurgeStaleIndices);
+	}
+	FTIStructIndex& Index = Indices.FindOrAdd(Struct);
+	// The weak pointer catches a new struct allocated at the address of a collected one
+	if (Index.Struct.Get() != Struct || Index.LinkHead != Struct->PropertyLink)
+	{
+		BuildIndex(Index, Struct);
+	}
+	return Index;
+}
+
+void FTIReflectionCache::BuildIndex(FTIStructIndex& Index, UStruct* Struct)
+{
+	Index.Struct = Struct;
+	Index.LinkHead = Struct->PropertyLink;
+	Index.Properties.Reset();
+	Index.Functions.Reset();
+	for (FProperty* Property = Struct->PropertyLink; Property; Property = Property->PropertyLinkNext)
+	{
+		// A struct's own properties come before inherited ones. Keep the first one, like a linear scan would
+		if (!Index.Properties.Contains(Property->GetFName()))
+		{
+			Index.Properties.Add(Property->GetFName(), Property);
+		}
+	}
+}
+
+void FTIReflectionCache::PurgeStaleIndices()
+{
+	for (auto It = Indices.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().Struct.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
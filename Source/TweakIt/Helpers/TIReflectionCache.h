@@ -0,0 +1,33 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Name lookup tables for a single UStruct. FName comparisons ignore case, which is what scripts expect
+struct FTIStructIndex
+{
+	TWeakObjectPtr<UStruct> Struct;
+	// Head of the PropertyLink chain the index was built from. Relinking a struct rebuilds the chain
+	FProperty* LinkHead = nullptr;
+	TMap<FName, FProperty*> Properties;
+	// Filled on demand. Names that aren't functions of the struct are stored as nullptr
+	TMap<FName, UFunction*> Functions;
+};
+
+class FTIReflectionCache
+{
+public:
+	static FProperty* FindProperty(UStruct* Struct, FName Name);
+	static UFunction* FindFunction(UStruct* Struct, FName Name);
+
+	static void Invalidate(UStruct* Struct);
+	static int32 Num();
+
+	static uint64 FunctionHits;
+	static uint64 FunctionMisses;
+private:
+	static FTIStructIndex& GetIndex(UStruct* Struct);
+	static void BuildIndex(FTIStructIndex& Index, UStruct* Struct);
+	static void PurgeStaleIndices();
+
+	static TMap<UStruct*, FTIStructIndex> Indices;
+	static FDelegateHandle PostGarbageCollectHandle;
+};
@@ -1,9 +1,13 @@
 ﻿#include "TIUFunctionBinder.h"
 
+#include "TIReflectionCache.h"
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
 #include "TweakIt/Logging/FTILog.h"
 
 UFunction* UTIUFunctionBinder::SignatureBuffer = nullptr;
-TMap<FGuid, FEvent*> UTIUFunctionBinder::Awaitables = {};
+TMap<FName, TFunction<void(FName)>> UTIUFunctionBinder::Awaitables = {};
+FCriticalSection UTIUFunctionBinder::AwaitablesLock;
 
 void UTIUFunctionBinder::AddNativeFunction(FNativeFuncPtr Function, FName Name)
 {
@@ -17,11 +21,13 @@ void UTIUFunctionBinder::AddNativeFunction(FNativeFuncPtr Function, FName Name)
 	ConstructUFunction(UFunc, Params);
 	UFunc->SetNativeFunc(Function);
 	StaticClass()->AddFunctionToFunctionMap(UFunc, Name);
+	FTIReflectionCache::Invalidate(StaticClass());
 }
 
 void UTIUFunctionBinder::AddFunction(UFunction* Function, FName Name)
 {
 	StaticClass()->AddFunctionToFunctionMap(Function, Name);
+	FTIReflectionCache::Invalidate(StaticClass());
 }
 
 template<typename... T>
@@ -44,26 +50,33 @@ UTIUFunctionBinder* UTIUFunctionBinder::Get()
 
 // TODO: Make this non-destructive
 // TODO: Remove function when done
-// TODO: Make sure the Event won't block or crash when triggering multiple times without waiting
-FEvent* UTIUFunctionBinder::MakeAwaitableFunction(FName& FunctionNameOut)
+void UTIUFunctionBinder::MakeAwaitableFunction(FName& FunctionNameOut, TFunction<void(FName)> OnTriggered)
 {
-	FGuid Guid = FGuid::NewGuid();
-	FEvent* Event = FPlatformProcess::CreateSynchEvent();
-	Awaitables.Add(Guid, Event);
-	FName FunctionName = FName(MakeFunctionName(TEXT("Awaitable"), Guid.ToString()));
+	FName FunctionName = FName(MakeFunctionName(TEXT("Awaitable"), FGuid::NewGuid().ToString()));
+	{
+		FScopeLock Lock(&AwaitablesLock);
+		Awaitables.Add(FunctionName, MoveTemp(OnTriggered));
+	}
 	AddNativeFunction([](UObject* Object, FFrame& Frame, void* Result)
 	{
-		FGuid Guid = FGuid();
-		FGuid::Parse(FPaths::GetPathLeaf(Frame.Node->GetName()), Guid);
-		FEvent** Event = Get()->Awaitables.Find(Guid);
-		if (Event == nullptr)
+		const FName Name = Frame.Node->GetFName();
+		TFunction<void(FName)> Callback;
+		{
+			FScopeLock Lock(&AwaitablesLock);
+			Awaitables.RemoveAndCopyValue(Name, Callback);
+		}
+		if (!Callback)
 		{
-			LOGL("Tried to trigger unknown event", Error)
+			LOGFV("Awaitable %s was already triggered", *Name.ToString())
+			return;
 		}
-		(*Event)->Trigger();
+		// Queued even on the game thread, so nothing resumes in the middle of a broadcast
+		AsyncTask(ENamedThreads::GameThread, [Callback, Name]
+		{
+			Callback(Name);
+		});
 	}, FunctionName);
 	FunctionNameOut = FunctionName;
-	return Event;
 }
 
 template<typename... T>
@@ -17,11 +17,14 @@ public:
 	static void RemoveFunction(T... Namespace);
 	
 	static UTIUFunctionBinder* Get();
-	static FEvent* MakeAwaitableFunction(FName& FunctionNameOut);
+	// Makes a function that, the first time it's called, queues OnTriggered on the game thread with the function's name
+	static void MakeAwaitableFunction(FName& FunctionNameOut, TFunction<void(FName)> OnTriggered);
 
 	template<typename... T>
 	static FString MakeFunctionName(T... Namespace);
 
 	static UFunction* SignatureBuffer;
-	static TMap<FGuid, FEvent*> Awaitables;
+	// Awaitable functions that weren't called yet. Delegates can fire from any thread
+	static TMap<FName, TFunction<void(FName)>> Awaitables;
+	static FCriticalSection AwaitablesLock;
 };
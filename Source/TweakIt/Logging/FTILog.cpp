@@ -1,35 +1,32 @@
 #include "FTILog.h"
 
 #include "FGAnimNotify_AkEventCurrentPotential.h"
+#include "FTILogWriter.h"
+#include "Misc/OutputDeviceHelper.h"
 #include "TweakIt/Lua/Scripting/TIScriptOrchestrator.h"
 
 DEFINE_LOG_CATEGORY(LogTweakIt)
 
-FString FTILog::CurrentScript = "TweakIt";
-TMap<FString, FOutputDeviceFile*> FTILog::Files = {};
-FOutputDeviceFile* FTILog::TweakItLog = new FOutputDeviceFile(*GetLogFilenameForScript("TweakIt"));
+thread_local FString FTILog::CurrentScript = "TweakIt";
+ELogVerbosity::Type FTILog::Verbosity = ELogVerbosity::Log;
 
 void FTILog::LogForScript(FString String, FString ScriptName, ELogVerbosity::Type Level)
 {
+	// Files are written by FTILogWriter's thread
+	FTILogWriter& Writer = FTILogWriter::Get();
 	if (ScriptName == "TweakIt" || ScriptName == "")
 	{
-		TweakItLog->Log(LogTweakIt.GetCategoryName(), Level, String);
+		Writer.Enqueue("TweakIt", FormatLine(String, Level));
 		return;
 	}
-	TweakItLog->Log(LogTweakIt.GetCategoryName(), Level, WrapStringWithScript(String, ScriptName));
-	FOutputDeviceFile* LogFile = GetLogFileForScript(ScriptName);
-	LogFile->Log(LogTweakIt.GetCategoryName(), Level, String);
+	Writer.Enqueue("TweakIt", FormatLine(WrapStringWithScript(String, ScriptName), Level));
+	Writer.Enqueue(ScriptName, FormatLine(String, Level));
 }
 
-FOutputDeviceFile* FTILog::GetLogFileForScript(FString ScriptName)
+FString FTILog::FormatLine(const FString& String, ELogVerbosity::Type Level)
 {
-	if (FOutputDeviceFile** ExistingFile = Files.Find(ScriptName))
-	{
-		return *ExistingFile;
-	}
-	FOutputDeviceFile* NewFile = new FOutputDeviceFile(*GetLogFilenameForScript(ScriptName));
-	Files.Add(ScriptName, NewFile);
-	return NewFile;
+	return FOutputDeviceHelper::FormatLogLine(Level, LogTweakIt.GetCategoryName(), *String, GPrintLogTimes,
+	                                          FPlatformTime::Seconds() - GStartTime) + LINE_TERMINATOR;
 }
 
 FString FTILog::GetLogFilenameForScript(FString ScriptName)
@@ -44,4 +41,20 @@ FString FTILog::WrapStringWithScript(FString String, FString ScriptName)
 		String = ScriptName + ": " + String;
 	}
 	return String;
-}
\ No newline at end of file
+}
+
+void FTILog::SetVerbosity(ELogVerbosity::Type Level)
+{
+	Verbosity = Level;
+	// Otherwise the engine's log would still drop what the script logs get
+	LogTweakIt.SetVerbosity(Level);
+}
+
+void FTILog::InitVerbosityFromCommandLine()
+{
+	FString Level;
+	if (FParse::Value(FCommandLine::Get(), TEXT("TweakItLogVerbosity="), Level))
+	{
+		SetVerbosity(ParseLogVerbosityFromString(Level));
+	}
+}
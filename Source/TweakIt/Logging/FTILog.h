@@ -2,27 +2,55 @@
 
 #include "../Helpers/StringConv.h"
 
-DECLARE_LOG_CATEGORY_EXTERN(LogTweakIt, Log, Log);   
+DECLARE_LOG_CATEGORY_EXTERN(LogTweakIt, Log, All);
 
+// Messages above this verbosity aren't compiled in. Trace logs cost nothing in shipping builds
+#ifndef TWEAKIT_LOG_COMPILED_VERBOSITY
+	#if UE_BUILD_SHIPPING
+		#define TWEAKIT_LOG_COMPILED_VERBOSITY ELogVerbosity::Log
+	#else
+		#define TWEAKIT_LOG_COMPILED_VERBOSITY ELogVerbosity::VeryVerbose
+	#endif
+#endif
+
+// Disabled messages are skipped before their string is built or formatted
 #define LOG(str) LOGL(str, Log)
 #define LOGL(str, level)\
-	UE_LOG(LogTweakIt, level, TEXT("%s"), *FTILog::WrapStringWithScript(FStringConv::ToFString(str), FTILog::CurrentScript));\
-	FTILog::LogForScript(FStringConv::ToFString(str), FTILog::CurrentScript, ELogVerbosity::level);
+	if (FTILog::IsEnabled(ELogVerbosity::level))\
+	{\
+		const FString TILogString = FStringConv::ToFString(str);\
+		UE_LOG(LogTweakIt, level, TEXT("%s"), *FTILog::WrapStringWithScript(TILogString, FTILog::CurrentScript));\
+		FTILog::LogForScript(TILogString, FTILog::CurrentScript, ELogVerbosity::level);\
+	}
 
 #define LOGF(str, ...) LOGFL(str, Log, __VA_ARGS__);
 #define LOGFL(str, level, ...) LOGL(FString::Printf(TEXT(str), __VA_ARGS__), level)
 
+// Verbose is for details of an operation, VeryVerbose (trace) for the marshalling layer and other per-access paths
+#define LOGV(str) LOGL(str, Verbose)
+#define LOGFV(str, ...) LOGFL(str, Verbose, __VA_ARGS__);
+#define LOGT(str) LOGL(str, VeryVerbose)
+#define LOGFT(str, ...) LOGFL(str, VeryVerbose, __VA_ARGS__);
+
 struct FTILog
 {
 	static void LogForScript(FString String, FString ScriptName, ELogVerbosity::Type Level);
 
-	static FOutputDeviceFile* GetLogFileForScript(FString ScriptName);
 	static FString GetLogFilenameForScript(FString ScriptName);
+	// Same format as the engine's log files
+	static FString FormatLine(const FString& String, ELogVerbosity::Type Level);
 
 	static FString WrapStringWithScript(FString String, FString ScriptName);
+
+	static FORCEINLINE bool IsEnabled(ELogVerbosity::Type Level)
+	{
+		return Level <= TWEAKIT_LOG_COMPILED_VERBOSITY && Level <= Verbosity;
+	}
+	static void SetVerbosity(ELogVerbosity::Type Level);
+	// Reads -TweakItLogVerbosity=<level> from the command line
+	static void InitVerbosityFromCommandLine();
 	
-	static FString CurrentScript;
-private:
-	static TMap<FString, FOutputDeviceFile*> Files;
-	static FOutputDeviceFile* TweakItLog;
+	// Per thread, scripts are compiled on worker threads
+	static thread_local FString CurrentScript;
+	static ELogVerbosity::Type Verbosity;
 };
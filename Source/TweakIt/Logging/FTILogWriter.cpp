@@ -0,0 +1,194 @@
+#include "FTILogWriter.h"
+
+#include "FTILog.h"
+#include "HAL/RunnableThread.h"
+
+FTILogWriter& FTILogWriter::Get()
+{
+	// Never destroyed, logging can happen during static destruction
+	static FTILogWriter* Writer = new FTILogWriter();
+	return *Writer;
+}
+
+FTILogWriter::FTILogWriter() : Cells(MakeUnique<FCell[]>(Capacity))
+{
+	for (uint64 i = 0; i < Capacity; i++)
+	{
+		Cells[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+	SystemErrorHandle = FCoreDelegates::OnHandleSystemError.AddRaw(this, &FTILogWriter::Flush);
+	if (!FPlatformProcess::SupportsMultithreading())
+	{
+		// Every line gets written as soon as it's queued
+		Stopping = true;
+		return;
+	}
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("TweakItLogWriter"), 0, TPri_BelowNormal);
+}
+
+FTILogWriter::~FTILogWriter()
+{
+	Shutdown();
+}
+
+void FTILogWriter::Enqueue(FString ScriptName, FString Line)
+{
+	uint64 Position = EnqueuePosition.load(std::memory_order_relaxed);
+	FCell* Cell;
+	for (;;)
+	{
+		Cell = &Cells[Position & (Capacity - 1)];
+		const uint64 Sequence = Cell->Sequence.load(std::memory_order_acquire);
+		const int64 Difference = static_cast<int64>(Sequence - Position);
+		if (Difference == 0)
+		{
+			if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (Difference < 0)
+		{
+			// The cell from the previous lap hasn't been written yet, the queue is full
+			Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			Position = EnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+	Cell->ScriptName = MoveTemp(ScriptName);
+	Cell->Line = MoveTemp(Line);
+	Cell->Sequence.store(Position + 1, std::memory_order_release);
+
+	if (Stopping.load(std::memory_order_relaxed))
+	{
+		Drain();
+	}
+	else if ((Position + 1) % WakeInterval == 0)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+void FTILogWriter::Flush()
+{
+	// The lock is recursive, so this also gets through when the writer thread itself crashed while draining
+	const double Deadline = FPlatformTime::Seconds() + FlushIntervalMs / 1000.0;
+	while (!DrainLock.TryLock())
+	{
+		if (FPlatformTime::Seconds() > Deadline)
+		{
+			// Another thread is mid-drain, racing it over the queue and the files would do more harm than the lost lines
+			return;
+		}
+		FPlatformProcess::SleepNoStats(0.001f);
+	}
+	DrainUnlocked();
+	DrainLock.Unlock();
+}
+
+void FTILogWriter::Shutdown()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	if (WakeEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+	FCoreDelegates::OnHandleSystemError.Remove(SystemErrorHandle);
+	FScopeLock Lock(&DrainLock);
+	Drain();
+	for (auto& File : Files)
+	{
+		delete File.Value;
+	}
+	Files.Empty();
+}
+
+uint32 FTILogWriter::Run()
+{
+	while (!Stopping.load(std::memory_order_relaxed))
+	{
+		WakeEvent->Wait(FlushIntervalMs);
+		Drain();
+	}
+	return 0;
+}
+
+void FTILogWriter::Stop()
+{
+	Stopping = true;
+	WakeEvent->Trigger();
+}
+
+void FTILogWriter::Drain()
+{
+	FScopeLock Lock(&DrainLock);
+	DrainUnlocked();
+}
+
+void FTILogWriter::DrainUnlocked()
+{
+	TMap<FString, FString> Batches;
+	FString ScriptName;
+	FString Line;
+	while (Dequeue(ScriptName, Line))
+	{
+		Batches.FindOrAdd(ScriptName).Append(Line);
+	}
+	const uint64 DroppedNow = Dropped.load(std::memory_order_relaxed);
+	if (DroppedNow != ReportedDropped)
+	{
+		Batches.FindOrAdd("TweakIt").Append(FString::Printf(
+			TEXT("%llu log messages were dropped because the log queue was full (%llu in total)%s"),
+			DroppedNow - ReportedDropped, DroppedNow, LINE_TERMINATOR));
+		ReportedDropped = DroppedNow;
+	}
+	for (auto& Batch : Batches)
+	{
+		Write(Batch.Key, Batch.Value);
+	}
+}
+
+bool FTILogWriter::Dequeue(FString& ScriptName, FString& Line)
+{
+	FCell& Cell = Cells[DequeuePosition & (Capacity - 1)];
+	// With a single consumer, anything else than the next lap's sequence means the cell isn't written yet
+	if (Cell.Sequence.load(std::memory_order_acquire) != DequeuePosition + 1)
+	{
+		return false;
+	}
+	ScriptName = MoveTemp(Cell.ScriptName);
+	Line = MoveTemp(Cell.Line);
+	Cell.Sequence.store(DequeuePosition + Capacity, std::memory_order_release);
+	DequeuePosition++;
+	return true;
+}
+
+void FTILogWriter::Write(const FString& ScriptName, const FString& Text)
+{
+	FArchive* File = Files.FindRef(ScriptName);
+	if (!File)
+	{
+		// Log files start over with every session, reopening one after a shutdown appends to it
+		const uint32 Flags = FILEWRITE_AllowRead | (Truncated.Contains(ScriptName) ? FILEWRITE_Append : 0);
+		File = IFileManager::Get().CreateFileWriter(*FTILog::GetLogFilenameForScript(ScriptName), Flags);
+		if (!File)
+		{
+			return;
+		}
+		Truncated.Add(ScriptName);
+		Files.Add(ScriptName, File);
+	}
+	FTCHARToUTF8 Converted(*Text);
+	File->Serialize(const_cast<ANSICHAR*>(Converted.Get()), Converted.Length());
+	File->Flush();
+}
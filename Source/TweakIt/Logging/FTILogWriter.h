@@ -0,0 +1,64 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+// Writes the TweakIt and script log files from a background thread.
+// Lines go through a bounded lock-free queue (Vyukov's MPMC ring, only ever drained by one consumer at a time)
+// and are written in batches, one write per file. A full queue drops the line instead of blocking the game thread
+class FTILogWriter : public FRunnable
+{
+public:
+	static FTILogWriter& Get();
+
+	// Line must already be formatted and end with a line terminator
+	void Enqueue(FString ScriptName, FString Line);
+	// Writes everything queued on the calling thread. Called while crashing, so it never waits long on the writer:
+	// if another thread keeps the lock, the flush is skipped
+	void Flush();
+	// Stops the thread, flushes and closes the files
+	void Shutdown();
+
+	uint64 GetDroppedCount() const { return Dropped.load(std::memory_order_relaxed); }
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	FTILogWriter();
+	virtual ~FTILogWriter() override;
+
+	void Drain();
+	// Drain, with the lock already held
+	void DrainUnlocked();
+	bool Dequeue(FString& ScriptName, FString& Line);
+	void Write(const FString& ScriptName, const FString& Text);
+
+	struct FCell
+	{
+		std::atomic<uint64> Sequence;
+		FString ScriptName;
+		FString Line;
+	};
+
+	static constexpr uint64 Capacity = 8192;
+	// The thread gets woken up every that many lines, otherwise it writes on a timer
+	static constexpr uint64 WakeInterval = 256;
+	static constexpr uint32 FlushIntervalMs = 100;
+
+	TUniquePtr<FCell[]> Cells;
+	std::atomic<uint64> EnqueuePosition{0};
+	uint64 DequeuePosition = 0;
+	std::atomic<uint64> Dropped{0};
+	uint64 ReportedDropped = 0;
+
+	// Held by whoever is draining, the thread or a flush
+	FCriticalSection DrainLock;
+	TMap<FString, FArchive*> Files;
+	TSet<FString> Truncated;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> Stopping{false};
+	FDelegateHandle SystemErrorHandle;
+};
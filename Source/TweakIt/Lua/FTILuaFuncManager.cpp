@@ -4,8 +4,22 @@
 #include "TweakIt/Helpers/TIReflection.h"
 #include "TweakIt/Helpers/TIUFunctionBinder.h"
 #include "TweakIt/Logging/FTILog.h"
+#include "LuaState.h"
+#include "PropertyMarshaller.h"
 
 TMap<FString, FLuaFunc> FTILuaFuncManager::SavedLuaFuncs = {};
+TMap<UFunction*, TSharedRef<FLuaHook>> FTILuaFuncManager::Hooks = {};
+
+namespace
+{
+	struct FHookCall
+	{
+		FLuaHook* Hook;
+		UObject* Context;
+		uint8* Locals;
+		void* Result;
+	};
+}
 
 FLuaFunc::FLuaFunc(lua_State* L) : L(L)
 {
@@ -71,76 +85,177 @@ TResult<FLuaFunc> FTILuaFuncManager::GetSavedLuaFunc(FString Name)
 	return *Func;
 }
 
-FNativeFuncPtr FTILuaFuncManager::SavedLuaFuncToNativeFunc(lua_State* L, FString Name)
+void FTILuaFuncManager::BindLuaFunction(lua_State* L, UFunction* Function, int Index)
 {
-	LOG("Making a native func out of a saved lua func")
-	TResult<FLuaFunc> LuaFunc = GetSavedLuaFunc(Name);
-	if (!LuaFunc)
+	FTILua::LuaT_ExpectLuaFunction(L, Index);
+	LOGF("Binding a Lua function to %s", *Function->GetFullName())
+	TSharedRef<FLuaHook> Hook = MakeShared<FLuaHook>();
+	Hook->State = FLuaState::Get(L);
+	Hook->OriginalFunc = Function->GetNativeFunc();
+	Hook->Function = Function;
+	for (FProperty* Prop = Function->PropertyLink; Prop; Prop = Prop->PropertyLinkNext)
+	{
+		if (Prop->HasAnyPropertyFlags(CPF_Parm) && !Prop->HasAnyPropertyFlags(CPF_ReturnParm))
+		{
+			Hook->Params.Add(Prop);
+		}
+	}
+	Hook->ReturnProperty = Function->GetReturnProperty();
+	if (TSharedRef<FLuaHook>* Existing = Hooks.Find(Function))
 	{
-		LOGFL("Could not find the saved function: %s", Warning, *LuaFunc.Err()->Error())
-		return nullptr;
+		// Rebinding keeps the function's real code around
+		Hook->OriginalFunc = (*Existing)->OriginalFunc;
+		luaL_unref((*Existing)->State->L, LUA_REGISTRYINDEX, (*Existing)->Ref);
 	}
-	LOG("could find")
-	return LuaCallerFunc;
+	lua_pushvalue(L, Index);
+	Hook->Ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	Hooks.Add(Function, Hook);
+	Function->SetNativeFunc(LuaCallerFunc);
 }
 
 TPair<UObject*, FName> FTILuaFuncManager::MakeGlobalLuaUFunction(lua_State* L, UFunction* Signature, int Index)
 {
 	FTILua::LuaT_ExpectLuaFunction(L, Index);
 	FString FunctionName = Signature->GetFullName() + FGuid::NewGuid().ToString();
-	DumpFunction(L, FunctionName, Index);
 	UFunction* Function = FTIReflection::CopyUFunction(Signature, FunctionName);
-	Function->SetNativeFunc(LuaCallerFunc);
+	BindLuaFunction(L, Function, Index);
 	UTIUFunctionBinder::AddFunction(Function, FName(FunctionName));
 	return TPair<UObject*, FName>(UTIUFunctionBinder::Get(), FName(FunctionName));
 }
 
+bool FTILuaFuncManager::HasHooks(FLuaState* State)
+{
+	for (auto& Hook : Hooks)
+	{
+		if (Hook.Value->State == State)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FTILuaFuncManager::UnbindState(FLuaState* State)
+{
+	for (auto It = Hooks.CreateIterator(); It; ++It)
+	{
+		FLuaHook& Hook = It.Value().Get();
+		if (Hook.State != State)
+		{
+			continue;
+		}
+		// Functions made for Lua keep calling LuaCallerFunc, which does nothing without a hook
+		UFunction* Function = Hook.Function.Get();
+		if (Function && Hook.OriginalFunc)
+		{
+			Function->SetNativeFunc(Hook.OriginalFunc);
+		}
+		It.RemoveCurrent();
+	}
+}
+
 int FTILuaFuncManager::WriterFunc(lua_State* L, const void* NewData, size_t DataSize, void* Descriptor)
 {
 	FLuaFunc* Desc = static_cast<FLuaFunc*>(Descriptor);
 	return !Desc->AddData(NewData, DataSize);
 }
 
-void FTILuaFuncManager::LuaCallerFunc(UObject* Context, FFrame& Frame, void* const Result)
+void FTILuaFuncManager::LuaCallerFunc(UObject* Context, FFrame& Stack, void* const Result)
 {
-	if (Frame.Node == nullptr)
+	// Blueprint bytecode calls native functions with its own frame, their parameters still have to be evaluated from
+	// its code. Everything else, ProcessEvent included, passes a frame of the function with the parameters in Locals
+	UFunction* Function = Stack.CurrentNativeFunction ? Stack.CurrentNativeFunction : Stack.Node;
+	if (Function == nullptr)
 	{
-		LOGL("Trying to call a LuaFunc but the Node was null", Error)
+		LOGL("Trying to call a LuaFunc but the function was null", Error)
 		return;
 	}
-	LOG("Calling wrapper function around Lua function")
-	FString FunctionName = Frame.Node->GetFullName();
-	TResult<FLuaFunc> LuaFunc = GetSavedLuaFunc(FunctionName);
-	if (!LuaFunc)
+	const bool FromBytecode = Function->HasAnyFunctionFlags(FUNC_Native) && Stack.Node != Function;
+	LOGT("Calling wrapper function around Lua function")
+	uint8* Locals = Stack.Locals;
+	// The caller's variables that out and reference parameters are written back to
+	TArray<TPair<FProperty*, void*>> OutParams;
+	if (FromBytecode)
 	{
-		LOGFL("Could not find Lua func %s", Error, *FunctionName)
-		return;
+		// Evaluated even without a hook, or the rest of the caller's code would be read from the wrong place
+		Locals = static_cast<uint8*>(FMemory_Alloca(FMath::Max(Function->ParmsSize, 1)));
+		FMemory::Memzero(Locals, Function->ParmsSize);
+		for (TFieldIterator<FProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+		{
+			if (It->HasAnyPropertyFlags(CPF_ReturnParm))
+			{
+				continue;
+			}
+			void* Value = It->ContainerPtrToValuePtr<void>(Locals);
+			It->InitializeValue(Value);
+			Stack.MostRecentPropertyAddress = nullptr;
+			Stack.Step(Stack.Object, Value);
+			if (It->HasAnyPropertyFlags(CPF_OutParm) && Stack.MostRecentPropertyAddress)
+			{
+				OutParams.Add({*It, Stack.MostRecentPropertyAddress});
+			}
+		}
+		P_FINISH
 	}
-	lua_State* L = LuaFunc->L;
-	LoadFunction(L, *LuaFunc, FunctionName);
-	LOG("Pushing context object")
-	FLuaUObject::ConstructObject(L, Context);
-	for (auto Prop = Frame.Node->PropertyLink; Prop; Prop = Prop->PropertyLinkNext)
+	if (TSharedRef<FLuaHook>* Found = Hooks.Find(Function))
 	{
-		if (Prop->HasAllPropertyFlags(CPF_ReturnParm) || !Prop->HasAllPropertyFlags(CPF_Parm) )
+		// Held here, the hook can bind other functions and reallocate the map
+		TSharedRef<FLuaHook> Hook = *Found;
+		lua_State* L = Hook->State->GetHookThread();
+		FHookCall Call = {&Hook.Get(), Context, Locals, Result};
+		lua_pushcfunction(L, CallHook);
+		lua_pushlightuserdata(L, &Call);
+		if (lua_pcall(L, 1, 0, 0) != LUA_OK)
 		{
-			continue;
+			FString Error = lua_tostring(L, -1);
+			LOGFL("Errored when calling func %s: %s", Error, *Function->GetFullName(), *Error)
+			lua_pop(L, 1);
+		}
+		if (Hook->State->GetRoot()->StepAfterHooks)
+		{
+			Hook->State->StepGarbageCollector(L);
 		}
 	}
-	FProperty* ReturnProperty = Frame.Node->GetReturnProperty();
-	LOG("Calling inner Lua func")
-	int r = lua_pcall(L, Frame.Node->NumParms + 1, ReturnProperty != nullptr, 0);
-	if (r != LUA_OK)
+	else
 	{
-		FString Error = lua_tostring(L, -1);
-		LOGFL("Errored when calling func %s: %s", Error, *FunctionName, *Error)
-		return;
+		LOGFL("Could not find Lua func %s", Error, *Function->GetFullName())
+	}
+	if (FromBytecode)
+	{
+		for (TPair<FProperty*, void*>& Out : OutParams)
+		{
+			Out.Key->CopyCompleteValue(Out.Value, Out.Key->ContainerPtrToValuePtr<void>(Locals));
+		}
+		for (TFieldIterator<FProperty> It(Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+		{
+			if (!It->HasAnyPropertyFlags(CPF_ReturnParm))
+			{
+				It->DestroyValue_InContainer(Locals);
+			}
+		}
+	}
+	LOGT("Done")
+}
+
+// Runs protected, so failing conversions don't escape into the engine
+int FTILuaFuncManager::CallHook(lua_State* L)
+{
+	FHookCall* Call = static_cast<FHookCall*>(lua_touserdata(L, 1));
+	FLuaHook* Hook = Call->Hook;
+	lua_rawgeti(L, LUA_REGISTRYINDEX, Hook->Ref);
+	LOGT("Pushing context object")
+	FLuaUObject::ConstructObject(L, Call->Context);
+	for (FProperty* Param : Hook->Params)
+	{
+		FTIPropertyMarshaller::ToLua(L, Param, Param->ContainerPtrToValuePtr<void>(Call->Locals));
 	}
-	if (ReturnProperty)
+	const bool Returns = Hook->ReturnProperty && Call->Result;
+	LOGT("Calling inner Lua func")
+	lua_call(L, Hook->Params.Num() + 1, Returns ? 1 : 0);
+	if (Returns)
 	{
-		LOG("Copying return value")
-		FTILua::LuaToProperty(L, ReturnProperty, Result, -1, true);
-		lua_pop(L, 1);
+		LOGT("Copying return value")
+		FTIPropertyMarshaller::FromLua(L, Hook->ReturnProperty, Call->Result, -1);
 	}
-	LOG("Done")
+	return 0;
 }
@@ -17,6 +17,21 @@ private:
 	TArray<uint8> Buf;
 };
 
+class FLuaState;
+
+// A Lua function bound to a UFunction. The closure stays in the registry, upvalues included
+struct FLuaHook
+{
+	FLuaState* State;
+	int Ref;
+	// Restored when the state goes away. Functions made for Lua don't have one
+	FNativeFuncPtr OriginalFunc;
+	TWeakObjectPtr<UFunction> Function;
+	// Passed after the context object, in order
+	TArray<FProperty*> Params;
+	FProperty* ReturnProperty;
+};
+
 class FTILuaFuncManager
 {
 public:
@@ -25,13 +40,20 @@ public:
 	static int LoadSavedFunction(lua_State* L, FString Name);
 	static TResult<FLuaFunc> GetSavedLuaFunc(FString Name);
 	
-	static FNativeFuncPtr SavedLuaFuncToNativeFunc(lua_State* L, FString Name);
-
+	// Makes the function call the Lua function at Index instead of its own code
+	static void BindLuaFunction(lua_State* L, UFunction* Function, int Index);
 	static TPair<UObject*, FName> MakeGlobalLuaUFunction(lua_State* L, UFunction* Signature, int Index);
 
+	static bool HasHooks(FLuaState* State);
+	// Gives the functions bound by the state their code back
+	static void UnbindState(FLuaState* State);
+
 private:
 	static int WriterFunc(lua_State* L, const void* NewData, size_t DataSize, void* Descriptor);
-	static void LuaCallerFunc(UObject* Context, FFrame& TheStack, void* const Z_Param__Result);
+	static void LuaCallerFunc(UObject* Context, FFrame& Stack, void* const Result);
+	static int CallHook(lua_State* L);
+
+	static TMap<UFunction*, TSharedRef<FLuaHook>> Hooks;
 public:
 	static TMap<FString, FLuaFunc> SavedLuaFuncs;
 };
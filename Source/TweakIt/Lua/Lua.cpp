@@ -6,10 +6,13 @@
 #include "FTILuaFuncManager.h"
 #include "IPlatformFilePak.h"
 #include "LuaState.h"
+#include "PropertyMarshaller.h"
+#include "UFunctionCallPlan.h"
 #include "Scripting/TIScriptOrchestrator.h"
 #include "TweakIt/TweakItTesting.h"
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Helpers/TIReflection.h"
+#include "TweakIt/Helpers/TIReflectionCache.h"
 #include "TweakIt/Helpers/TIContentRegistration.h"
 
 using namespace std;
@@ -106,20 +109,23 @@ void FTILua::StackDump(lua_State* L)
 	LOG(Separator)
 }
 
-int FTILua::CallUFunction(lua_State* L, UObject* Object, UFunction* Function, int StartIndex)
+void FTILua::LuaT_KeepParentAlive(lua_State* L, int Parent)
 {
-	check(Function->IsValidLowLevel())
-	check(Object->IsValidLowLevel())
-	void* Params = FMemory_Alloca(Function->ParmsSize);
-	PopulateUFunctionParams(L, Function, Params, StartIndex);
-	Function->ProcessEvent(Function, Params);
-	FProperty* ReturnProperty = Function->GetReturnProperty();
-	if (ReturnProperty)
+	// Object and class wrappers are shared through the object cache and don't point into anything
+	if (!luaL_testudata(L, -1, FLuaUStruct::Name) && !luaL_testudata(L, -1, FLuaTArray::Name))
 	{
-		PropertyToLua(L, ReturnProperty, Params);
+		return;
 	}
-	FTIReflection::CleanUFunctionParams(Function, Params);
-	return ReturnProperty->IsValidLowLevel();
+	Parent = lua_absindex(L, Parent);
+	lua_pushvalue(L, Parent);
+	lua_setiuservalue(L, -2, 1);
+}
+
+int FTILua::CallUFunction(lua_State* L, UObject* Object, UFunction* Function, int StartIndex)
+{
+	check(Function->IsValidLowLevel())
+	TSharedRef<FTICallPlan> Plan = FTICallPlan::Get(Function);
+	return Plan->Call(L, Object, StartIndex);
 }
 
 void FTILua::UFunctionToLua(lua_State* L, UFunction* Function, UObject* Object)
@@ -128,307 +134,18 @@ void FTILua::UFunctionToLua(lua_State* L, UFunction* Function, UObject* Object)
 	FLuaUFunction::Construct(L, Function, Object);
 }
 
-void FTILua::PopulateUFunctionParams(lua_State* L, UFunction* Function, void* Params, int StartIndex) {
-	int i = StartIndex;
-	for (FProperty* Prop = Function->PropertyLink; Prop; Prop = Prop->PropertyLinkNext)
-	{
-		if (Prop->HasAnyPropertyFlags(CPF_ReturnParm) || !Prop->HasAllPropertyFlags(CPF_Parm) || Prop->HasAllPropertyFlags(CPF_ReferenceParm))
-		{
-			continue;
-		}
-		Prop->InitializeValue_InContainer(Params);
-		LuaToProperty(L, Prop, Params, i);
-		i++;
-	}
-}
-
-// Mostly borrowed from FIN's source. Thanks Pana !
 void FTILua::PropertyToLua(lua_State* L, FProperty* Property, void* Container, bool Local /*= false*/)
 {
-	LOGF("Transforming from Property %s to Lua", *Property->GetName());
-	if (Local)
-	{
-		Container = static_cast<uint8*>(Container) - Property->GetOffset_ForDebug();
-	}
-	if (FBoolProperty* BoolProp = CastField<FBoolProperty>(Property))
-	{
-		lua_pushboolean(L, BoolProp->GetPropertyValue_InContainer(Container));
-	}
-	else if (FInt8Property* Int8Prop = CastField<FInt8Property>(Property))
-	{
-		lua_pushinteger(L, Int8Prop->GetPropertyValue_InContainer(Container));
-	}
-	else if (FInt16Property* Int16Prop = CastField<FInt16Property>(Property))
-	{
-		lua_pushinteger(L, Int16Prop->GetPropertyValue_InContainer(Container));
-	}
-	else if (FIntProperty* IntProp = CastField<FIntProperty>(Property))
-	{
-		lua_pushinteger(L, IntProp->GetPropertyValue_InContainer(Container));
-	}
-	else if (FInt64Property* Int64Prop = CastField<FInt64Property>(Property))
-	{
-		lua_pushinteger(L, Int64Prop->GetPropertyValue_InContainer(Container));
-	}
-	else if (FUInt16Property* UInt16Prop = CastField<FUInt16Property>(Property))
-	{
-		lua_pushinteger(L, UInt16Prop->GetPropertyValue_InContainer(Container));
-	}
-	else if (FUInt32Property* UInt32Prop = CastField<FUInt32Property>(Property))
-	{
-		lua_pushinteger(L, UInt32Prop->GetPropertyValue_InContainer(Container));
-	}
-	else if (FUInt64Property* UInt64Prop = CastField<FUInt64Property>(Property))
-	{
-		lua_pushinteger(L, UInt64Prop->GetPropertyValue_InContainer(Container));
-	}
-	else if (FFloatProperty* FloatProp = CastField<FFloatProperty>(Property))
-	{
-		lua_pushnumber(L, FloatProp->GetPropertyValue_InContainer(Container));
-	}
-	else if (FDoubleProperty* DoubleProp = CastField<FDoubleProperty>(Property))
-	{
-		lua_pushnumber(L, DoubleProp->GetPropertyValue_InContainer(Container));
-	}
-	else if (FStrProperty* StrProp = CastField<FStrProperty>(Property))
-	{
-		FString String = StrProp->GetPropertyValue_InContainer(Container);
-		lua_pushstring(L, TCHAR_TO_UTF8(*String));
-	}
-	else if (FNameProperty* NameProp = CastField<FNameProperty>(Property))
-	{
-		FString String = NameProp->ContainerPtrToValuePtr<FName>(Container)->ToString();
-		lua_pushstring(L, TCHAR_TO_UTF8(*String));
-	}
-	else if (FTextProperty* TextProp = CastField<FTextProperty>(Property))
-	{
-		FString String = TextProp->ContainerPtrToValuePtr<FText>(Container)->ToString();
-		lua_pushstring(L, TCHAR_TO_UTF8(*String));
-	}
-	else if (FClassProperty* ClassProp = CastField<FClassProperty>(Property))
-	{
-		FLuaUClass::ConstructClass(L, *ClassProp->ContainerPtrToValuePtr<UClass*>(Container));
-	}
-	else if (FEnumProperty* EnumProp = CastField<FEnumProperty>(Property))
-	{
-		int64 EnumValue = *EnumProp->ContainerPtrToValuePtr<uint8>(Container);
-		UEnum* Enum = EnumProp->GetEnum();
-		if (!Enum->IsValidEnumValue(EnumValue))
-		{
-			luaL_error(L, "Enum value wasn't valid. Please report this to Feyko");
-		}
-		FName Name = Enum->GetNameByValue(EnumValue);
-		FString StringName = Name.ToString();
-		lua_pushstring(L, TCHAR_TO_UTF8(*StringName));
-	}
-	else if (FStructProperty* StructProp = CastField<FStructProperty>(Property))
-	{
-		void* StructValue = StructProp->ContainerPtrToValuePtr<void>(Container);
-		FLuaUStruct::ConstructStruct(L, StructProp->Struct, StructValue);
-	}
-	else if (FObjectProperty* ObjectProp = CastField<FObjectProperty>(Property))
-	{
-		FLuaUObject::ConstructObject(L, ObjectProp->GetPropertyValue_InContainer(Container));
-	}
-	else if (FArrayProperty* ArrayProp = CastField<FArrayProperty>(Property))
-	{
-		FLuaTArray::ConstructArray(L, ArrayProp, Container);
-	}
-	else if (FDelegateProperty* DelegateProp = CastField<FDelegateProperty>(Property))
-	{
-		FScriptDelegate* Value = DelegateProp->ContainerPtrToValuePtr<FScriptDelegate>(Container);
-		FLuaFDelegate::Construct(L, DelegateProp->SignatureFunction, Value);
-	}
-	else if (FInterfaceProperty* InterfaceProp = CastField<FInterfaceProperty>(Property))
-	{
-		FScriptInterface* Interface = InterfaceProp->ContainerPtrToValuePtr<FScriptInterface>(Container);
-		FLuaUObject::ConstructObject(L, Interface->GetObject());
-	}
-	else if (FFieldPathProperty* FieldPathProp = CastField<FFieldPathProperty>(Property))
-	{
-		lua_pushstring(L, TCHAR_TO_UTF8(*FieldPathProp->GetPropertyValuePtr_InContainer(Container)->ToString()));
-	}
-	else
-	{
-		FString Error = FString::Printf(TEXT("Property type %s is unsupported. Please report this to Feyko"), *Property->GetCPPType());
-		luaL_error(L, TCHAR_TO_UTF8(*Error));
-	}
+	LOGFT("Transforming from Property %s to Lua", *Property->GetName());
+	void* Value = Local ? Container : Property->ContainerPtrToValuePtr<void>(Container);
+	FTIPropertyMarshaller::ToLua(L, Property, Value);
 }
 
-// Mostly borrowed from FIN's source. Thanks Pana !
 void FTILua::LuaToProperty(lua_State* L, FProperty* Property, void* Container, int Index, bool Local /*= false*/)
 {
-	LOGF("Transforming from Lua to Property %s", *Property->GetName());
-	if (Local)
-	{
-		LOG("Localising property container")
-		Container = static_cast<uint8*>(Container) - Property->GetOffset_ForDebug();
-	}
-	if (FBoolProperty* BoolProp = CastField<FBoolProperty>(Property))
-	{
-		luaL_argexpected(L, lua_isboolean(L, Index), Index, "boolean");
-		BoolProp->SetPropertyValue_InContainer(Container, LuaT_CheckBoolean(L, Index));
-	}
-	else if (FInt8Property* Int8Prop = CastField<FInt8Property>(Property))
-	{
-		Int8Prop->SetPropertyValue_InContainer(Container, luaL_checkinteger(L, Index));
-	}
-	else if (FInt16Property* Int16Prop = CastField<FInt16Property>(Property))
-	{
-		Int16Prop->SetPropertyValue_InContainer(Container, luaL_checkinteger(L, Index));
-	}
-	else if (FIntProperty* IntProp = CastField<FIntProperty>(Property))
-	{
-		int Int = luaL_checkinteger(L, Index);
-		IntProp->SetPropertyValue_InContainer(Container, Int);
-	}
-	else if (FInt64Property* Int64Prop = CastField<FInt64Property>(Property))
-	{
-		*Int64Prop->ContainerPtrToValuePtr<std::int64_t>(Container) = luaL_checkinteger(L, Index);
-	}
-	else if (FUInt16Property* UInt16Prop = CastField<FUInt16Property>(Property))
-	{
-		UInt16Prop->SetPropertyValue_InContainer(Container, luaL_checkinteger(L, Index));
-	}
-	else if (FUInt32Property* UInt32Prop = CastField<FUInt32Property>(Property))
-	{
-		UInt32Prop->SetPropertyValue_InContainer(Container, luaL_checkinteger(L, Index));
-	}
-	else if (FUInt64Property* UInt64Prop = CastField<FUInt64Property>(Property))
-	{
-		UInt64Prop->SetPropertyValue_InContainer(Container, luaL_checkinteger(L, Index));
-	}
-	else if (FFloatProperty* FloatProp = CastField<FFloatProperty>(Property))
-	{
-		FloatProp->SetPropertyValue_InContainer(Container, luaL_checknumber(L, Index));
-	}
-	else if (FDoubleProperty* DoubleProp = CastField<FDoubleProperty>(Property))
-	{
-		DoubleProp->SetPropertyValue_InContainer(Container, luaL_checknumber(L, Index));
-	}
-	else if (FStrProperty* StrProp = CastField<FStrProperty>(Property))
-	{
-		FString String = luaL_checkstring(L, Index);
-		StrProp->SetPropertyValue_InContainer(Container, String);
-	}
-	else if (FNameProperty* NameProp = CastField<FNameProperty>(Property))
-	{
-		NameProp->SetPropertyValue_InContainer(Container, luaL_checkstring(L, Index));
-	}
-	else if (FTextProperty* TextProp = CastField<FTextProperty>(Property))
-	{
-		TextProp->SetPropertyValue_InContainer(Container, FText::FromString(luaL_checkstring(L, Index)));
-	}
-	else if (FClassProperty* ClassProp = CastField<FClassProperty>(Property))
-	{
-		FLuaUClass* LuaUClass = FLuaUClass::Get(L, Index);
-		ClassProp->SetPropertyValue_InContainer(Container, LuaUClass->Class);
-	}
-	else if (FEnumProperty* EnumProp = CastField<FEnumProperty>(Property))
-	{
-		FName EnumValueName = luaL_checkstring(L, Index);
-		FString EnumValueString = EnumValueName.ToString();
-		UEnum* Enum = EnumProp->GetEnum();
-		if (!EnumValueString.StartsWith(Enum->GetName()))
-		{
-			EnumValueString = Enum->GetName() + "::" + EnumValueString;
-			EnumValueName = FName(EnumValueString);
-		}
-		if (!Enum->IsValidEnumName(EnumValueName))
-		{
-			FString ValidValuesStr;
-			for (int i = 0; i < Enum->NumEnums(); ++i)
-			{
-				if (Enum->ContainsExistingMax() && Enum->GetIndexByValue(Enum->GetMaxEnumValue()) == i)
-				{
-					break;
-				}
-				ValidValuesStr += Enum->GetNameByIndex(i).ToString() + "\n";
-			}
-			ValidValuesStr = ValidValuesStr.TrimEnd();
-			
-			luaL_error(L, "invalid enum value %s for enum type %s. Valid values are:\n%s",
-			           TCHAR_TO_UTF8(*EnumValueName.ToString()), TCHAR_TO_UTF8(*Enum->GetName()),
-			           TCHAR_TO_UTF8(*ValidValuesStr));
-			
-			return;
-		}
-		int64 EnumValue = Enum->GetValueByName(EnumValueName);
-		*EnumProp->ContainerPtrToValuePtr<uint8>(Container) = static_cast<uint8>(EnumValue);
-	}
-	else if (FStructProperty* StructProp = CastField<FStructProperty>(Property))
-	{
-		FLuaUStruct* rStruct = FLuaUStruct::Get(L, Index);
-		if (!(StructProp->Struct->GetFullName() == rStruct->Struct->GetFullName()))
-		{
-			luaL_error(L, "Mismatched struct types (%s <- %s)",
-			           TCHAR_TO_UTF8(*StructProp->Struct->GetName()), TCHAR_TO_UTF8(*rStruct->Struct->GetName()));
-			return;
-		}
-		StructProp->CopyCompleteValue_InContainer(Container, rStruct->Values);
-		void* NewValue = StructProp->ContainerPtrToValuePtr<void>(Container);
-		rStruct->Values = NewValue;
-	}
-	else if (FObjectProperty* ObjectProp = CastField<FObjectProperty>(Property))
-	{
-		UObject* Object = lua_isnil(L, Index) ? nullptr : FLuaUObject::Get(L, Index)->Object;
-		ObjectProp->SetPropertyValue_InContainer(Container, Object);
-	}
-	else if (FArrayProperty* ArrayProp = CastField<FArrayProperty>(Property))
-	{
-		luaL_argexpected(L, lua_istable(L, Index), Index, "array");
-		FScriptArray* ArrayValue = ArrayProp->ContainerPtrToValuePtr<FScriptArray>(Container);
-
-		int InputLen = luaL_len(L, Index);
-		int ElementSize = ArrayProp->Inner->ElementSize;
-		ArrayValue->Empty(InputLen, ElementSize);
-		ArrayValue->AddZeroed(InputLen, ElementSize);
-
-		uint8* Data = static_cast<uint8*>(ArrayValue->GetData());
-		for (int i = 0; i < InputLen; ++i)
-		{
-			lua_pushinteger(L, i + 1);
-			lua_gettable(L, Index);
-			LuaToProperty(L, ArrayProp->Inner, Data + ElementSize * i, Index + 1);
-			lua_pop(L, 1);
-		}
-	}
-	else if (FDelegateProperty* DelegateProp = CastField<FDelegateProperty>(Property))
-	{
-		luaL_error(L, "Delegate assignment is not yet supported");
-	}
-	else if (FInterfaceProperty* InterfaceProp = CastField<FInterfaceProperty>(Property))
-	{
-		UObject* Object = lua_isnil(L, Index) ? nullptr : FLuaUObject::Get(L, Index)->Object;
-		FScriptInterface* InterfacePtr = InterfaceProp->ContainerPtrToValuePtr<FScriptInterface>(Container);
-		void* ObjectInterface = nullptr;
-		if(Object)
-		{
-			UClass* InterfaceClass = InterfaceProp->InterfaceClass;
-			ObjectInterface = Object->GetInterfaceAddress(InterfaceClass);
-			if (!ObjectInterface)
-			{
-				FString Error = FString::Printf(
-					TEXT("Tried to assign object %s to interface of type %s but it does not implement said interface."),
-					*Object->GetName(), *InterfaceClass->GetName());
-				luaL_error(L, TCHAR_TO_UTF8(*Error));
-				return;
-			}
-		}
-		*InterfacePtr = FScriptInterface(Object, ObjectInterface);
-	}
-	else if (FFieldPathProperty* FieldPathProp = CastField<FFieldPathProperty>(Property))
-	{
-		FString PathString = luaL_checkstring(L, Index);
-		FFieldPath Path = FFieldPath();
-		Path.Generate(*PathString);
-		FieldPathProp->SetPropertyValue_InContainer(Container, Path);
-	}
-	else
-	{
-		FString Error = FString::Printf(TEXT("Property type %s is unsupported. Please report this to Feyko"), *Property->GetCPPType());
-		luaL_error(L, TCHAR_TO_UTF8(*Error));
-	}
+	LOGFT("Transforming from Lua to Property %s", *Property->GetName());
+	void* Value = Local ? Container : Property->ContainerPtrToValuePtr<void>(Container);
+	FTIPropertyMarshaller::FromLua(L, Property, Value, Index);
 }
 
 
@@ -530,7 +247,7 @@ int FTILua::Lua_Test(lua_State* L)
 
 int FTILua::Lua_WaitForEvent(lua_State* L)
 {
-	FString Event = luaL_checkstring(L, 1);
+	const FName Event = UTF8_TO_TCHAR(luaL_checkstring(L, 1));
 	bool Unique = LuaT_OptBoolean(L, 2, true);
 	if (Unique && FTIScriptOrchestrator::Get()->HasEventPassed(Event))
 	{
@@ -552,6 +269,31 @@ int FTILua::Lua_WaitForMod(lua_State* L)
 	return 0;
 }
 
+int FTILua::Lua_Sleep(lua_State* L)
+{
+	const double Seconds = FMath::Max(luaL_checknumber(L, 1), 0.0);
+	FLuaState::Get(L)->TimeWaitedFor = FPlatformTime::Seconds() + Seconds;
+	lua_yield(L, 0);
+	return 0;
+}
+
+int FTILua::Lua_NextTick(lua_State* L)
+{
+	lua_settop(L, 0);
+	lua_pushinteger(L, 1);
+	Lua_WaitFrames(L);
+	return 0;
+}
+
+int FTILua::Lua_WaitFrames(lua_State* L)
+{
+	const lua_Integer Frames = luaL_checkinteger(L, 1);
+	luaL_argcheck(L, Frames >= 1, 1, "must wait at least one frame");
+	FLuaState::Get(L)->FrameWaitedFor = FTIScriptOrchestrator::Get()->GetFrame() + Frames;
+	lua_yield(L, 0);
+	return 0;
+}
+
 int FTILua::Lua_DumpFunction(lua_State* L)
 {
 	FString Name = luaL_checkstring(L, 1);
@@ -571,3 +313,137 @@ int FTILua::Lua_LoadFunction(lua_State* L)
 	lua_setglobal(L, TCHAR_TO_UTF8(*Name));
 	return 1;
 }
+
+int FTILua::Lua_GetReflectionStats(lua_State* L)
+{
+	lua_newtable(L);
+	lua_pushinteger(L, FTIReflectionCache::FunctionHits);
+	lua_setfield(L, -2, "FunctionHits");
+	lua_pushinteger(L, FTIReflectionCache::FunctionMisses);
+	lua_setfield(L, -2, "FunctionMisses");
+	lua_pushinteger(L, FTIReflectionCache::Num());
+	lua_setfield(L, -2, "IndexedStructs");
+	return 1;
+}
+
+int FTILua::Lua_BeginTweaks(lua_State* L)
+{
+	FLuaState::Get(L)->TweakDepth++;
+	return 0;
+}
+
+int FTILua::Lua_CommitTweaks(lua_State* L)
+{
+	FLuaState* State = FLuaState::Get(L);
+	if (State->TweakDepth == 0)
+	{
+		return luaL_error(L, "CommitTweaks called without BeginTweaks");
+	}
+	// Nested transactions are committed by the outermost one
+	if (--State->TweakDepth > 0)
+	{
+		return 0;
+	}
+	PropagationStatsToLua(L, State->Tweaks.Propagate());
+	return 1;
+}
+
+int FTILua::Lua_GetHeapStats(lua_State* L)
+{
+	const FTILuaAllocator& Allocator = FLuaState::Get(L)->GetAllocator();
+	lua_newtable(L);
+	lua_pushinteger(L, Allocator.Bytes);
+	lua_setfield(L, -2, "Bytes");
+	lua_pushinteger(L, Allocator.PeakBytes);
+	lua_setfield(L, -2, "PeakBytes");
+	lua_pushinteger(L, Allocator.Allocations);
+	lua_setfield(L, -2, "Allocations");
+	lua_pushinteger(L, Allocator.Limit);
+	lua_setfield(L, -2, "Limit");
+
+	FLuaState* Root = FLuaState::Get(L)->GetRoot();
+	const FLuaState::FGCStats& Stats = Root->GCStats;
+	lua_pushstring(L, TCHAR_TO_UTF8(*Root->GCMode));
+	lua_setfield(L, -2, "Mode");
+	lua_pushnumber(L, lua_gc(L, LUA_GCCOUNT) + lua_gc(L, LUA_GCCOUNTB) / 1024.0);
+	lua_setfield(L, -2, "Kilobytes");
+	lua_pushinteger(L, Stats.Collections);
+	lua_setfield(L, -2, "Collections");
+	lua_pushinteger(L, Stats.Steps);
+	lua_setfield(L, -2, "Steps");
+	lua_pushnumber(L, Stats.LastPauseMs);
+	lua_setfield(L, -2, "LastPauseMs");
+	lua_pushnumber(L, Stats.MaxPauseMs);
+	lua_setfield(L, -2, "MaxPauseMs");
+	lua_pushnumber(L, Stats.TotalPauseMs);
+	lua_setfield(L, -2, "TotalPauseMs");
+	return 1;
+}
+
+int FTILua::Lua_SetGCMode(lua_State* L)
+{
+	// Not an FString, luaL_argerror and the option checks skip destructors
+	const char* Mode = luaL_checkstring(L, 1);
+	// Missing parameters are passed as 0, which keeps their current value
+	auto Option = [L](const char* Name)
+	{
+		if (!lua_istable(L, 2))
+		{
+			return 0;
+		}
+		lua_getfield(L, 2, Name);
+		const int Value = static_cast<int>(luaL_optinteger(L, -1, 0));
+		lua_pop(L, 1);
+		return Value;
+	};
+	int Previous;
+	if (FCStringAnsi::Stricmp(Mode, "generational") == 0)
+	{
+		Previous = lua_gc(L, LUA_GCGEN, Option("MinorMultiplier"), Option("MajorMultiplier"));
+	}
+	else if (FCStringAnsi::Stricmp(Mode, "incremental") == 0)
+	{
+		Previous = lua_gc(L, LUA_GCINC, Option("Pause"), Option("StepMultiplier"), Option("StepSize"));
+	}
+	else
+	{
+		return luaL_argerror(L, 1, "expected incremental or generational");
+	}
+	FLuaState* Root = FLuaState::Get(L)->GetRoot();
+	Root->GCMode = Mode;
+	if (lua_istable(L, 2))
+	{
+		lua_getfield(L, 2, "StepAfterHooks");
+		Root->StepAfterHooks = static_cast<bool>(lua_toboolean(L, -1));
+		lua_pop(L, 1);
+	}
+	lua_pushstring(L, Previous == LUA_GCGEN ? "generational" : "incremental");
+	return 1;
+}
+
+void FTILua::PropagationStatsToLua(lua_State* L, const FTIPropagationStats& Stats)
+{
+	lua_newtable(L);
+	lua_pushinteger(L, Stats.Changes);
+	lua_setfield(L, -2, "Changes");
+	lua_pushinteger(L, Stats.Objects);
+	lua_setfield(L, -2, "Objects");
+	lua_pushinteger(L, Stats.Properties);
+	lua_setfield(L, -2, "Properties");
+	lua_pushnumber(L, Stats.Milliseconds);
+	lua_setfield(L, -2, "Milliseconds");
+}
+
+int FTILua::Lua_SetLogVerbosity(lua_State* L)
+{
+	// Not an FString, luaL_argerror skips destructors
+	const char* Level = luaL_checkstring(L, 1);
+	const ELogVerbosity::Type Verbosity = ParseLogVerbosityFromString(UTF8_TO_TCHAR(Level));
+	// Unknown names parse as NoLogging, which would silence every script
+	if (Verbosity == ELogVerbosity::NoLogging && FCStringAnsi::Stricmp(Level, "NoLogging") != 0)
+	{
+		return luaL_argerror(L, 1, "expected a log verbosity like Log, Verbose or VeryVerbose");
+	}
+	FTILog::SetVerbosity(Verbosity);
+	return 0;
+}
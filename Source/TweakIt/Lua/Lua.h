@@ -14,19 +14,32 @@ public:
 	static bool LuaT_CheckBoolean(lua_State* L, int Index);
 	static FString LuaT_CheckStringable(lua_State* L, int Index);
 	static bool LuaT_OptBoolean(lua_State* L, int Index, bool Default);
+	// If the value on top is a struct or array wrapper, it points into the value of the wrapper at Parent, which is
+	// kept alive through its first user value
+	static void LuaT_KeepParentAlive(lua_State* L, int Parent);
+	// Constructs the wrapper directly in a new userdata with T::Name's metatable. Its __gc has to call the destructor
+	template<typename T, typename... ArgTypes>
+	static T* LuaT_NewUserdata(lua_State* L, ArgTypes&&... Args)
+	{
+		T* Instance = new(lua_newuserdatauv(L, sizeof(T), 1)) T(Forward<ArgTypes>(Args)...);
+		luaL_setmetatable(L, T::Name);
+		return Instance;
+	}
 
 	static void RegisterMetatable(lua_State* L, const char* Name, TArray<luaL_Reg>);
 	static void RegisterMethod(lua_State* L, luaL_Reg Reg);
 	static bool CheckLua(lua_State* L, int Returned);
 	static void StackDump(lua_State* L);
 
+	// Returns the return value, then out and reference parameters
 	static int CallUFunction(lua_State* L, UObject* Object, UFunction* Function, int StartIndex);
 	static void UFunctionToLua(lua_State* L, UFunction* Function, UObject* Object);
-	static void PopulateUFunctionParams(lua_State* L, UFunction* Function, void* Params, int StartIndex);
 
-	// Mostly borrowed from FIN's source. Thanks Pana !
+	// Conversions are done by FTIPropertyMarshaller. Local means Container already points to the value
 	static void PropertyToLua(lua_State* L, FProperty* Property, void* Container, bool Local = false);
 	static void LuaToProperty(lua_State* L, FProperty* Property, void* Container, int Index, bool Local = false);
+	// Pushes {Changes, Objects, Properties, Milliseconds}
+	static void PropagationStatsToLua(lua_State* L, const struct FTIPropagationStats& Stats);
 
 	static int Lua_GetClass(lua_State* L);
 	static int Lua_MakeStructInstance(lua_State* L);
@@ -37,6 +50,15 @@ public:
 	static int Lua_Test(lua_State* L);
 	static int Lua_WaitForEvent(lua_State* L);
 	static int Lua_WaitForMod(lua_State* L);
+	static int Lua_Sleep(lua_State* L);
+	static int Lua_NextTick(lua_State* L);
+	static int Lua_WaitFrames(lua_State* L);
 	static int Lua_DumpFunction(lua_State* L);
 	static int Lua_LoadFunction(lua_State* L);
+	static int Lua_GetReflectionStats(lua_State* L);
+	static int Lua_SetLogVerbosity(lua_State* L);
+	static int Lua_BeginTweaks(lua_State* L);
+	static int Lua_CommitTweaks(lua_State* L);
+	static int Lua_GetHeapStats(lua_State* L);
+	static int Lua_SetGCMode(lua_State* L);
 };
@@ -1,22 +1,123 @@
 #include "LuaState.h"
 
+#include "FTILuaFuncManager.h"
 #include "TweakIt/Logging/FTILog.h"
 
-FLuaState::FLuaState() : PlatformEventWaitedFor(nullptr)
+FLuaState::FLuaState(FLuaState* Parent) : Root(Parent ? Parent->Root : this)
 {
-	L = luaL_newstate();
+	if (IsChild())
+	{
+		L = lua_newthread(Root->L);
+		ThreadRef = luaL_ref(Root->L, LUA_REGISTRYINDEX);
+		ObjectCache = Root->ObjectCache;
+		// Globals the script sets stay in its environment
+		lua_newtable(L);
+		lua_newtable(L);
+		lua_pushglobaltable(L);
+		lua_setfield(L, -2, "__index");
+		lua_setmetatable(L, -2);
+		// require goes through the environment, recording what this script loads
+		lua_newtable(L);
+		lua_pushvalue(L, -1);
+		RequiredModules = luaL_ref(L, LUA_REGISTRYINDEX);
+		lua_getglobal(L, "require");
+		lua_pushcclosure(L, RecordingRequire, 2);
+		lua_setfield(L, -2, "require");
+		Environment = luaL_ref(L, LUA_REGISTRYINDEX);
+		*static_cast<FLuaState**>(lua_getextraspace(L)) = this;
+		return;
+	}
+	L = lua_newstate(FTILuaAllocator::Alloc, &Allocator);
+	lua_atpanic(L, Panic);
 	OpenLibs();
 	RegisterMetadatas();
 	RegisterGlobalFunctions();
-	lua_pushlightuserdata(L, this);
-	lua_setfield(L, LUA_REGISTRYINDEX, "State");
+	CreateObjectCache();
+	InstallCollectionCounter(L);
+	// Coroutines copy the main thread's extra space when they're created
+	*static_cast<FLuaState**>(lua_getextraspace(L)) = this;
 }
 
 FLuaState::~FLuaState()
 {
+	FTILuaFuncManager::UnbindState(this);
+	if (IsChild())
+	{
+		// The thread is collected with the rest of the VM's garbage
+		luaL_unref(Root->L, LUA_REGISTRYINDEX, Environment);
+		luaL_unref(Root->L, LUA_REGISTRYINDEX, RequiredModules);
+		luaL_unref(Root->L, LUA_REGISTRYINDEX, HookThreadRef);
+		luaL_unref(Root->L, LUA_REGISTRYINDEX, ThreadRef);
+		return;
+	}
+	Closing = true;
 	lua_close(L);
 }
 
+void FLuaState::SetEnvironment(int Index)
+{
+	if (!IsChild())
+	{
+		return;
+	}
+	Index = lua_absindex(L, Index);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, Environment);
+	if (!lua_setupvalue(L, Index, 1))
+	{
+		lua_pop(L, 1);
+	}
+}
+
+void FLuaState::PushRequiredModules()
+{
+	if (IsChild())
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, RequiredModules);
+		return;
+	}
+	lua_getfield(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+}
+
+int FLuaState::RecordingRequire(lua_State* L)
+{
+	luaL_checkstring(L, 1);
+	lua_settop(L, 1);
+	// Modules loaded before, at 3
+	lua_getfield(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+	lua_newtable(L);
+	lua_pushnil(L);
+	while (lua_next(L, 2))
+	{
+		lua_pop(L, 1);
+		lua_pushvalue(L, -1);
+		lua_pushboolean(L, true);
+		lua_rawset(L, 3);
+	}
+	// The module and the loader data, at 4 and 5
+	lua_pushvalue(L, lua_upvalueindex(2));
+	lua_pushvalue(L, 1);
+	lua_call(L, 1, 2);
+	lua_pushvalue(L, 1);
+	lua_pushboolean(L, true);
+	lua_rawset(L, lua_upvalueindex(1));
+	lua_pushnil(L);
+	while (lua_next(L, 2))
+	{
+		lua_pop(L, 1);
+		lua_pushvalue(L, -1);
+		if (lua_rawget(L, 3) == LUA_TNIL)
+		{
+			lua_pushvalue(L, -2);
+			lua_pushboolean(L, true);
+			lua_rawset(L, lua_upvalueindex(1));
+		}
+		lua_pop(L, 1);
+	}
+	lua_pushvalue(L, 4);
+	lua_pushvalue(L, 5);
+	return 2;
+}
+
 void FLuaState::OpenLibs()
 {
 	luaL_Reg Libs[] = {
@@ -44,6 +145,7 @@ void FLuaState::RegisterMetadatas()
 	FLuaUStruct::RegisterMetadata(L);
 	FLuaFDelegate::RegisterMetadata(L);
 	FLuaUFunction::RegisterMetadata(L);
+	FLuaObjectIterator::RegisterMetadata(L);
 }
 
 void FLuaState::RegisterGlobalFunctions()
@@ -54,14 +156,134 @@ void FLuaState::RegisterGlobalFunctions()
 	}
 }
 
+void FLuaState::CreateObjectCache()
+{
+	lua_newtable(L);
+	lua_newtable(L);
+	lua_pushstring(L, "v");
+	lua_setfield(L, -2, "__mode");
+	lua_setmetatable(L, -2);
+	ObjectCache = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+void FLuaState::StepGarbageCollector(lua_State* Thread)
+{
+	const double Start = FPlatformTime::Seconds();
+	lua_gc(Thread, LUA_GCSTEP, 0);
+	const double Milliseconds = (FPlatformTime::Seconds() - Start) * 1000;
+	FGCStats& Stats = Root->GCStats;
+	Stats.Steps++;
+	Stats.LastPauseMs = Milliseconds;
+	Stats.MaxPauseMs = FMath::Max(Stats.MaxPauseMs, Milliseconds);
+	Stats.TotalPauseMs += Milliseconds;
+}
+
+void FLuaState::InstallCollectionCounter(lua_State* Thread)
+{
+	// An unreferenced table, its finalizer runs once the collector got to it and makes the next one
+	lua_newtable(Thread);
+	if (luaL_newmetatable(Thread, "TweakItCollectionCounter"))
+	{
+		lua_pushcfunction(Thread, CountCollection);
+		lua_setfield(Thread, -2, "__gc");
+	}
+	lua_setmetatable(Thread, -2);
+	lua_pop(Thread, 1);
+}
+
+int FLuaState::CountCollection(lua_State* L)
+{
+	FLuaState* Root = Get(L)->Root;
+	Root->GCStats.Collections++;
+	if (!Root->Closing)
+	{
+		InstallCollectionCounter(L);
+	}
+	return 0;
+}
+
+int FLuaState::Panic(lua_State* L)
+{
+	const char* Message = lua_tostring(L, -1);
+	LOGFL("Unprotected error in a Lua state: %s", Error, Message ? UTF8_TO_TCHAR(Message) : TEXT("error object is not a string"))
+	return 0;
+}
+
 void FLuaState::RegisterWorldContext(UObject* Context)
 {
+	if (IsChild())
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, Environment);
+		FLuaUObject::ConstructObject(L, Context);
+		lua_setfield(L, -2, "WorldContext");
+		lua_pop(L, 1);
+		return;
+	}
 	FLuaUObject::ConstructObject(L, Context);
 	lua_setglobal(L, "WorldContext");
 }
 
 FLuaState* FLuaState::Get(lua_State* L)
 {
-	lua_getfield(L, LUA_REGISTRYINDEX, "State");
-	return FTILua::LuaT_CheckLightUserdata<FLuaState>(L, -1);
+	return *static_cast<FLuaState**>(lua_getextraspace(L));
+}
+
+lua_State* FLuaState::GetHookThread()
+{
+	if (!HookThread)
+	{
+		HookThread = lua_newthread(L);
+		// Referenced from the registry so it's never collected before the state
+		HookThreadRef = luaL_ref(L, LUA_REGISTRYINDEX);
+		// New threads copy the main thread's extra space, a child's hooks must find the child
+		*static_cast<FLuaState**>(lua_getextraspace(HookThread)) = this;
+	}
+	return HookThread;
+}
+
+void FLuaState::RemoveReference(int32 Handle)
+{
+	Root->References.RemoveAt(Handle);
+}
+
+int32 FLuaState::AddDelegateReference(FScriptDelegate* Delegate)
+{
+	return Root->DelegateReferences.Add(Delegate);
+}
+
+void FLuaState::RemoveDelegateReference(int32 Handle)
+{
+	Root->DelegateReferences.RemoveAt(Handle);
+}
+
+void FLuaState::SetJournal(TSharedPtr<FTIChangeJournal> NewJournal)
+{
+	Journal = NewJournal;
+	Tweaks.Journal = Journal.Get();
+}
+
+void FLuaState::CommitOpenTweaks()
+{
+	if (TweakDepth == 0)
+	{
+		return;
+	}
+	TweakDepth = 0;
+	const FTIPropagationStats Stats = Tweaks.Propagate();
+	LOGF("Committed the open tweaks: %d changes, %d objects, %d properties in %.2fms", Stats.Changes, Stats.Objects,
+	     Stats.Properties, Stats.Milliseconds)
+}
+
+void FLuaState::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Tweaks.AddReferencedObjects(Collector);
+	for (UObject** Reference : References)
+	{
+		Collector.AddReferencedObject(*Reference);
+	}
+	for (FScriptDelegate* Delegate : DelegateReferences)
+	{
+		UObject* Object = Delegate->GetUObject();
+		Collector.AddReferencedObject(Object);
+	}
 }
\ No newline at end of file
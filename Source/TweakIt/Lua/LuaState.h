@@ -1,23 +1,105 @@
 #pragma once
 #include "Lua.h"
+#include "TILuaAllocator.h"
+#include "TweakIt/Helpers/TIDefaultValuePropagator.h"
 
-class FLuaState
+// Also reports the UObjects held by the state's wrappers to the GC, in one go instead of one FGCObject per wrapper.
+// A state made with a parent is a thread of the parent's VM with its own _ENV table, falling back to the parent's
+// globals. It shares the parent's libraries, metatables and wrappers, and costs a thread and a table
+class FLuaState : public FGCObject
 {
 public:
-	FLuaState();
+	explicit FLuaState(FLuaState* Parent = nullptr);
 	~FLuaState();
 
+	bool IsChild() const { return Root != this; }
+	// Makes the function on top of the stack use this state's environment, its first upvalue being _ENV
+	void SetEnvironment(int Index);
+	// Pushes a table keyed by the names of the modules loaded for this state. package.loaded is shared by the
+	// children, so a child records the ones it required itself and those first loaded while it did
+	void PushRequiredModules();
+
 	void RegisterWorldContext(UObject* Context);
 	static FLuaState* Get(lua_State* L);
 
-	FString EventWaitedFor;
-	FEvent* PlatformEventWaitedFor;
+	// Wrappers living in userdata register the address of their UObject pointers. Userdata never moves
+	// Children forward them to the root, userdata may be collected from any thread of the VM
+	template<typename T>
+	int32 AddReference(T*& Object)
+	{
+		return Root->References.Add(reinterpret_cast<UObject**>(&Object));
+	}
+	void RemoveReference(int32 Handle);
+	// Keeps the object a delegate is bound to alive, whichever it's bound to at the time
+	int32 AddDelegateReference(FScriptDelegate* Delegate);
+	void RemoveDelegateReference(int32 Handle);
+
+	// Thread running the Lua functions bound to UFunctions, the main thread may be suspended when they're called.
+	// Each child has its own, so the hooks write to the child's journal and tweaks
+	lua_State* GetHookThread();
+
+	// Registry reference to the weak valued table mapping UObject pointers to their wrapper
+	int ObjectCache = LUA_NOREF;
+
+	// Default value changes made between BeginTweaks and CommitTweaks, propagated to the objects on commit
+	FTIDefaultValuePropagator Tweaks;
+	int32 TweakDepth = 0;
+	// Commits the tweaks a script left open
+	void CommitOpenTweaks();
+
+	// Where the script's property writes are recorded, if anywhere
+	TSharedPtr<FTIChangeJournal> Journal;
+	void SetJournal(TSharedPtr<FTIChangeJournal> NewJournal);
+
+	// The VM's allocator, shared with the children
+	FTILuaAllocator& GetAllocator() { return Root->Allocator; }
+	FLuaState* GetRoot() const { return Root; }
+
+	// Garbage collection of the VM. Collections are counted by a finalizer, pauses are the steps TweakIt runs
+	struct FGCStats
+	{
+		int32 Collections = 0;
+		int32 Steps = 0;
+		double LastPauseMs = 0;
+		double MaxPauseMs = 0;
+		double TotalPauseMs = 0;
+	};
+	FGCStats GCStats;
+	FString GCMode = "incremental";
+	// Runs a collection step after each bound Lua function, instead of wherever the collector runs next
+	bool StepAfterHooks = false;
+	// Thread is any running thread of the VM
+	void StepGarbageCollector(lua_State* Thread);
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+	FName EventWaitedFor;
+	// Set by Sleep and WaitFrames, the orchestrator frame or FPlatformTime::Seconds() to wake up at
+	uint64 FrameWaitedFor = 0;
+	double TimeWaitedFor = 0;
 	
 	lua_State* L;
 private:
 	void OpenLibs();
 	void RegisterMetadatas();
 	void RegisterGlobalFunctions();
+	void CreateObjectCache();
+	static int Panic(lua_State* L);
+	static void InstallCollectionCounter(lua_State* Thread);
+	static int CountCollection(lua_State* L);
+	static int RecordingRequire(lua_State* L);
+
+	FTILuaAllocator Allocator;
+	TSparseArray<UObject**> References;
+	TSparseArray<FScriptDelegate*> DelegateReferences;
+	lua_State* HookThread = nullptr;
+	FLuaState* Root;
+	// Registry references to a child's thread, environment and required modules
+	int ThreadRef = LUA_NOREF;
+	int Environment = LUA_NOREF;
+	int RequiredModules = LUA_NOREF;
+	int HookThreadRef = LUA_NOREF;
+	bool Closing = false;
 
 	inline static TArray<luaL_Reg> GlobalFunctions = {
 		{"GetClass", FTILua::Lua_GetClass},
@@ -30,7 +112,16 @@ private:
 		{"Test", FTILua::Lua_Test},
 		{"WaitForEvent", FTILua::Lua_WaitForEvent},
 		{"WaitForMod", FTILua::Lua_WaitForMod},
+		{"Sleep", FTILua::Lua_Sleep},
+		{"NextTick", FTILua::Lua_NextTick},
+		{"WaitFrames", FTILua::Lua_WaitFrames},
 		{"DumpFunction", FTILua::Lua_DumpFunction},
-		{"LoadFunction", FTILua::Lua_LoadFunction}
+		{"LoadFunction", FTILua::Lua_LoadFunction},
+		{"GetReflectionStats", FTILua::Lua_GetReflectionStats},
+		{"SetLogVerbosity", FTILua::Lua_SetLogVerbosity},
+		{"BeginTweaks", FTILua::Lua_BeginTweaks},
+		{"CommitTweaks", FTILua::Lua_CommitTweaks},
+		{"GetHeapStats", FTILua::Lua_GetHeapStats},
+		{"SetGCMode", FTILua::Lua_SetGCMode}
 	};
 };
@@ -0,0 +1,440 @@
+#include "PropertyMarshaller.h"
+
+#include "Lua.h"
+
+TMap<FFieldClass*, FTIPropertyConverter> FTIPropertyMarshaller::Converters = {};
+TMap<FFieldClass*, FTIPropertyConverter> FTIPropertyMarshaller::Resolved = {};
+
+// Mostly borrowed from FIN's source. Thanks Pana !
+namespace
+{
+	template <typename TProperty>
+	void IntegerToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushinteger(L, static_cast<TProperty*>(Property)->GetPropertyValue(Value));
+	}
+
+	template <typename TProperty>
+	void LuaToInteger(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		static_cast<TProperty*>(Property)->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+	}
+
+	template <typename TProperty>
+	void NumberToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushnumber(L, static_cast<TProperty*>(Property)->GetPropertyValue(Value));
+	}
+
+	template <typename TProperty>
+	void LuaToNumber(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		static_cast<TProperty*>(Property)->SetPropertyValue(Value, luaL_checknumber(L, Index));
+	}
+
+	void BoolToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushboolean(L, static_cast<FBoolProperty*>(Property)->GetPropertyValue(Value));
+	}
+
+	void LuaToBool(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		static_cast<FBoolProperty*>(Property)->SetPropertyValue(Value, FTILua::LuaT_CheckBoolean(L, Index));
+	}
+
+	void StrToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushstring(L, TCHAR_TO_UTF8(**static_cast<FString*>(Value)));
+	}
+
+	void LuaToStr(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		*static_cast<FString*>(Value) = UTF8_TO_TCHAR(luaL_checkstring(L, Index));
+	}
+
+	void NameToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushstring(L, TCHAR_TO_UTF8(*static_cast<FName*>(Value)->ToString()));
+	}
+
+	void LuaToName(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		*static_cast<FName*>(Value) = FName(luaL_checkstring(L, Index));
+	}
+
+	void TextToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushstring(L, TCHAR_TO_UTF8(*static_cast<FText*>(Value)->ToString()));
+	}
+
+	void LuaToText(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		*static_cast<FText*>(Value) = FText::FromString(luaL_checkstring(L, Index));
+	}
+
+	void ClassToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FLuaUClass::ConstructClass(L, *static_cast<UClass**>(Value));
+	}
+
+	void LuaToClass(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		static_cast<FClassProperty*>(Property)->SetPropertyValue(Value, FLuaUClass::Get(L, Index)->Class);
+	}
+
+	void EnumToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FEnumProperty* EnumProp = static_cast<FEnumProperty*>(Property);
+		int64 EnumValue = EnumProp->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value);
+		UEnum* Enum = EnumProp->GetEnum();
+		if (!Enum->IsValidEnumValue(EnumValue))
+		{
+			luaL_error(L, "Enum value wasn't valid. Please report this to Feyko");
+		}
+		lua_pushstring(L, TCHAR_TO_UTF8(*Enum->GetNameByValue(EnumValue).ToString()));
+	}
+
+	void LuaToEnum(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		FEnumProperty* EnumProp = static_cast<FEnumProperty*>(Property);
+		FName EnumValueName = luaL_checkstring(L, Index);
+		FString EnumValueString = EnumValueName.ToString();
+		UEnum* Enum = EnumProp->GetEnum();
+		if (!EnumValueString.StartsWith(Enum->GetName()))
+		{
+			EnumValueString = Enum->GetName() + "::" + EnumValueString;
+			EnumValueName = FName(EnumValueString);
+		}
+		if (!Enum->IsValidEnumName(EnumValueName))
+		{
+			FString ValidValuesStr;
+			for (int i = 0; i < Enum->NumEnums(); ++i)
+			{
+				if (Enum->ContainsExistingMax() && Enum->GetIndexByValue(Enum->GetMaxEnumValue()) == i)
+				{
+					break;
+				}
+				ValidValuesStr += Enum->GetNameByIndex(i).ToString() + "\n";
+			}
+			ValidValuesStr = ValidValuesStr.TrimEnd();
+
+			luaL_error(L, "invalid enum value %s for enum type %s. Valid values are:\n%s",
+			           TCHAR_TO_UTF8(*EnumValueName.ToString()), TCHAR_TO_UTF8(*Enum->GetName()),
+			           TCHAR_TO_UTF8(*ValidValuesStr));
+			return;
+		}
+		EnumProp->GetUnderlyingProperty()->SetIntPropertyValue(Value, Enum->GetValueByName(EnumValueName));
+	}
+
+	void StructToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FLuaUStruct::ConstructStruct(L, static_cast<FStructProperty*>(Property)->Struct, Value);
+	}
+
+	void LuaToStruct(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		FStructProperty* StructProp = static_cast<FStructProperty*>(Property);
+		FLuaUStruct* rStruct = FLuaUStruct::Get(L, Index);
+		if (StructProp->Struct != rStruct->Struct)
+		{
+			luaL_error(L, "Mismatched struct types (%s <- %s)",
+			           TCHAR_TO_UTF8(*StructProp->Struct->GetName()), TCHAR_TO_UTF8(*rStruct->Struct->GetName()));
+			return;
+		}
+		StructProp->CopyCompleteValue(Value, rStruct->Values);
+	}
+
+	void ObjectToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FLuaUObject::ConstructObject(L, static_cast<FObjectProperty*>(Property)->GetObjectPropertyValue(Value));
+	}
+
+	void LuaToObject(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		UObject* Object = lua_isnil(L, Index) ? nullptr : FLuaUObject::Get(L, Index)->Object;
+		static_cast<FObjectProperty*>(Property)->SetObjectPropertyValue(Value, Object);
+	}
+
+	void ArrayToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FLuaTArray::ConstructArray(L, static_cast<FArrayProperty*>(Property), Value);
+	}
+
+	void LuaToArray(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		luaL_argexpected(L, lua_istable(L, Index), Index, "array");
+		FTIPropertyMarshaller::TableToArray(L, static_cast<FArrayProperty*>(Property), Value, Index);
+	}
+
+	void DelegateToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FDelegateProperty* DelegateProp = static_cast<FDelegateProperty*>(Property);
+		FLuaFDelegate::Construct(L, DelegateProp->SignatureFunction, static_cast<FScriptDelegate*>(Value));
+	}
+
+	void LuaToDelegate(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		luaL_error(L, "Delegate assignment is not yet supported");
+	}
+
+	void InterfaceToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FLuaUObject::ConstructObject(L, static_cast<FScriptInterface*>(Value)->GetObject());
+	}
+
+	void LuaToInterface(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		UObject* Object = lua_isnil(L, Index) ? nullptr : FLuaUObject::Get(L, Index)->Object;
+		void* ObjectInterface = nullptr;
+		if (Object)
+		{
+			UClass* InterfaceClass = static_cast<FInterfaceProperty*>(Property)->InterfaceClass;
+			ObjectInterface = Object->GetInterfaceAddress(InterfaceClass);
+			if (!ObjectInterface)
+			{
+				FString Error = FString::Printf(
+					TEXT("Tried to assign object %s to interface of type %s but it does not implement said interface."),
+					*Object->GetName(), *InterfaceClass->GetName());
+				luaL_error(L, TCHAR_TO_UTF8(*Error));
+				return;
+			}
+		}
+		*static_cast<FScriptInterface*>(Value) = FScriptInterface(Object, ObjectInterface);
+	}
+
+	void FieldPathToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		lua_pushstring(L, TCHAR_TO_UTF8(*static_cast<FFieldPath*>(Value)->ToString()));
+	}
+
+	void LuaToFieldPath(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		FString PathString = luaL_checkstring(L, Index);
+		FFieldPath Path = FFieldPath();
+		Path.Generate(*PathString);
+		*static_cast<FFieldPath*>(Value) = Path;
+	}
+
+	enum class EArrayFastPath
+	{
+		None,
+		Int,
+		Float,
+		Double,
+		Bool,
+		Object,
+	};
+
+	// Exact classes only, FClassProperty is an FObjectProperty but needs its own wrapper
+	EArrayFastPath GetArrayFastPath(FProperty* Inner)
+	{
+		FFieldClass* InnerClass = Inner->GetClass();
+		if (InnerClass == FIntProperty::StaticClass()) return EArrayFastPath::Int;
+		if (InnerClass == FFloatProperty::StaticClass()) return EArrayFastPath::Float;
+		if (InnerClass == FDoubleProperty::StaticClass()) return EArrayFastPath::Double;
+		if (InnerClass == FObjectProperty::StaticClass()) return EArrayFastPath::Object;
+		if (InnerClass == FBoolProperty::StaticClass() && static_cast<FBoolProperty*>(Inner)->IsNativeBool())
+		{
+			return EArrayFastPath::Bool;
+		}
+		return EArrayFastPath::None;
+	}
+
+	lua_Number CheckElementNumber(lua_State* L, int Element)
+	{
+		int IsNumber = 0;
+		const lua_Number Number = lua_tonumberx(L, -1, &IsNumber);
+		if (!IsNumber)
+		{
+			luaL_error(L, "array element %d is a %s, expected a number", Element, luaL_typename(L, -1));
+		}
+		return Number;
+	}
+
+	lua_Integer CheckElementInteger(lua_State* L, int Element)
+	{
+		int IsInteger = 0;
+		const lua_Integer Integer = lua_tointegerx(L, -1, &IsInteger);
+		if (!IsInteger)
+		{
+			luaL_error(L, "array element %d is a %s, expected an integer", Element, luaL_typename(L, -1));
+		}
+		return Integer;
+	}
+
+	void UnsupportedToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		FString Error = FString::Printf(TEXT("Property type %s is unsupported. Please report this to Feyko"), *Property->GetCPPType());
+		luaL_error(L, TCHAR_TO_UTF8(*Error));
+	}
+
+	void LuaToUnsupported(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		UnsupportedToLua(L, Property, Value);
+	}
+}
+
+FTIPropertyConverter FTIPropertyMarshaller::GetConverter(FProperty* Property)
+{
+	FFieldClass* PropertyClass = Property->GetClass();
+	if (FTIPropertyConverter* Converter = Resolved.Find(PropertyClass))
+	{
+		return *Converter;
+	}
+	if (Converters.Num() == 0)
+	{
+		RegisterDefaultConverters();
+	}
+	FTIPropertyConverter Found = {UnsupportedToLua, LuaToUnsupported};
+	for (FFieldClass* FieldClass = PropertyClass; FieldClass; FieldClass = FieldClass->GetSuperClass())
+	{
+		if (FTIPropertyConverter* Converter = Converters.Find(FieldClass))
+		{
+			Found = *Converter;
+			break;
+		}
+	}
+	Resolved.Add(PropertyClass, Found);
+	return Found;
+}
+
+void FTIPropertyMarshaller::RegisterConverter(FFieldClass* FieldClass, FTIPropertyConverter Converter)
+{
+	if (Converters.Num() == 0)
+	{
+		RegisterDefaultConverters();
+	}
+	Converters.Add(FieldClass, Converter);
+	Resolved.Reset();
+}
+
+void FTIPropertyMarshaller::ToLua(lua_State* L, FProperty* Property, void* Value)
+{
+	GetConverter(Property).ToLua(L, Property, Value);
+}
+
+void FTIPropertyMarshaller::FromLua(lua_State* L, FProperty* Property, void* Value, int Index)
+{
+	GetConverter(Property).FromLua(L, Property, Value, lua_absindex(L, Index));
+}
+
+void FTIPropertyMarshaller::ArrayToTable(lua_State* L, FArrayProperty* Property, void* Value, int Owner)
+{
+	Owner = Owner ? lua_absindex(L, Owner) : 0;
+	FScriptArrayHelper Array(Property, Value);
+	const int32 Num = Array.Num();
+	lua_createtable(L, Num, 0);
+	uint8* Data = Array.GetRawPtr();
+	switch (GetArrayFastPath(Property->Inner))
+	{
+	case EArrayFastPath::Int:
+		for (int32 i = 0; i < Num; i++)
+		{
+			lua_pushinteger(L, reinterpret_cast<int32*>(Data)[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		break;
+	case EArrayFastPath::Float:
+		for (int32 i = 0; i < Num; i++)
+		{
+			lua_pushnumber(L, reinterpret_cast<float*>(Data)[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		break;
+	case EArrayFastPath::Double:
+		for (int32 i = 0; i < Num; i++)
+		{
+			lua_pushnumber(L, reinterpret_cast<double*>(Data)[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		break;
+	case EArrayFastPath::Bool:
+		for (int32 i = 0; i < Num; i++)
+		{
+			lua_pushboolean(L, reinterpret_cast<bool*>(Data)[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		break;
+	case EArrayFastPath::Object:
+		for (int32 i = 0; i < Num; i++)
+		{
+			FLuaUObject::ConstructObject(L, reinterpret_cast<UObject**>(Data)[i]);
+			lua_rawseti(L, -2, i + 1);
+		}
+		break;
+	default:
+		FTIPropertyConverter Inner = GetConverter(Property->Inner);
+		for (int32 i = 0; i < Num; i++)
+		{
+			Inner.ToLua(L, Property->Inner, Array.GetRawPtr(i));
+			if (Owner)
+			{
+				FTILua::LuaT_KeepParentAlive(L, Owner);
+			}
+			lua_rawseti(L, -2, i + 1);
+		}
+	}
+}
+
+void FTIPropertyMarshaller::TableToArray(lua_State* L, FArrayProperty* Property, void* Value, int Index)
+{
+	Index = lua_absindex(L, Index);
+	luaL_checktype(L, Index, LUA_TTABLE);
+	FScriptArrayHelper Array(Property, Value);
+	const int32 Num = lua_rawlen(L, Index);
+	Array.EmptyAndAddValues(Num);
+	uint8* Data = Array.GetRawPtr();
+	const EArrayFastPath FastPath = GetArrayFastPath(Property->Inner);
+	FTIPropertyConverter Inner = FastPath == EArrayFastPath::None ? GetConverter(Property->Inner) : FTIPropertyConverter();
+	for (int32 i = 0; i < Num; i++)
+	{
+		lua_rawgeti(L, Index, i + 1);
+		switch (FastPath)
+		{
+		case EArrayFastPath::Int:
+			reinterpret_cast<int32*>(Data)[i] = static_cast<int32>(CheckElementInteger(L, i + 1));
+			break;
+		case EArrayFastPath::Float:
+			reinterpret_cast<float*>(Data)[i] = static_cast<float>(CheckElementNumber(L, i + 1));
+			break;
+		case EArrayFastPath::Double:
+			reinterpret_cast<double*>(Data)[i] = CheckElementNumber(L, i + 1);
+			break;
+		case EArrayFastPath::Bool:
+			// Same check as the converter, anything but a boolean is an error rather than truthy
+			reinterpret_cast<bool*>(Data)[i] = FTILua::LuaT_CheckBoolean(L, lua_gettop(L));
+			break;
+		case EArrayFastPath::Object:
+			reinterpret_cast<UObject**>(Data)[i] = lua_isnil(L, -1) ? nullptr : FLuaUObject::Get(L, lua_gettop(L))->Object;
+			break;
+		default:
+			Inner.FromLua(L, Property->Inner, Array.GetRawPtr(i), lua_gettop(L));
+		}
+		lua_pop(L, 1);
+	}
+}
+
+void FTIPropertyMarshaller::RegisterDefaultConverters()
+{
+	Converters.Add(FBoolProperty::StaticClass(), {BoolToLua, LuaToBool});
+	Converters.Add(FInt8Property::StaticClass(), {IntegerToLua<FInt8Property>, LuaToInteger<FInt8Property>});
+	Converters.Add(FInt16Property::StaticClass(), {IntegerToLua<FInt16Property>, LuaToInteger<FInt16Property>});
+	Converters.Add(FIntProperty::StaticClass(), {IntegerToLua<FIntProperty>, LuaToInteger<FIntProperty>});
+	Converters.Add(FInt64Property::StaticClass(), {IntegerToLua<FInt64Property>, LuaToInteger<FInt64Property>});
+	Converters.Add(FUInt16Property::StaticClass(), {IntegerToLua<FUInt16Property>, LuaToInteger<FUInt16Property>});
+	Converters.Add(FUInt32Property::StaticClass(), {IntegerToLua<FUInt32Property>, LuaToInteger<FUInt32Property>});
+	Converters.Add(FUInt64Property::StaticClass(), {IntegerToLua<FUInt64Property>, LuaToInteger<FUInt64Property>});
+	Converters.Add(FFloatProperty::StaticClass(), {NumberToLua<FFloatProperty>, LuaToNumber<FFloatProperty>});
+	Converters.Add(FDoubleProperty::StaticClass(), {NumberToLua<FDoubleProperty>, LuaToNumber<FDoubleProperty>});
+	Converters.Add(FStrProperty::StaticClass(), {StrToLua, LuaToStr});
+	Converters.Add(FNameProperty::StaticClass(), {NameToLua, LuaToName});
+	Converters.Add(FTextProperty::StaticClass(), {TextToLua, LuaToText});
+	Converters.Add(FClassProperty::StaticClass(), {ClassToLua, LuaToClass});
+	Converters.Add(FEnumProperty::StaticClass(), {EnumToLua, LuaToEnum});
+	Converters.Add(FStructProperty::StaticClass(), {StructToLua, LuaToStruct});
+	Converters.Add(FObjectProperty::StaticClass(), {ObjectToLua, LuaToObject});
+	Converters.Add(FArrayProperty::StaticClass(), {ArrayToLua, LuaToArray});
+	Converters.Add(FDelegateProperty::StaticClass(), {DelegateToLua, LuaToDelegate});
+	Converters.Add(FInterfaceProperty::StaticClass(), {InterfaceToLua, LuaToInterface});
+	Converters.Add(FFieldPathProperty::StaticClass(), {FieldPathToLua, LuaToFieldPath});
+}
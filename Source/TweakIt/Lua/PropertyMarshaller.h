@@ -0,0 +1,39 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "lib/lua.hpp"
+
+// Converters work on a pointer to the property's value, not on its container
+typedef void (*FTIPropertyToLuaFunc)(lua_State* L, FProperty* Property, void* Value);
+typedef void (*FTILuaToPropertyFunc)(lua_State* L, FProperty* Property, void* Value, int Index);
+
+struct FTIPropertyConverter
+{
+	FTIPropertyToLuaFunc ToLua;
+	FTILuaToPropertyFunc FromLua;
+};
+
+class FTIPropertyMarshaller
+{
+public:
+	static FTIPropertyConverter GetConverter(FProperty* Property);
+
+	// Registers the converter for a property type. Subtypes without their own converter fall back to it.
+	// Call this before scripts start, the resolved converters get thrown away every time.
+	static void RegisterConverter(FFieldClass* FieldClass, FTIPropertyConverter Converter);
+
+	static void ToLua(lua_State* L, FProperty* Property, void* Value);
+	static void FromLua(lua_State* L, FProperty* Property, void* Value, int Index);
+
+	// Whole array conversions to and from a sequence. int, float, double, bool and UObject* elements
+	// are converted in tight loops instead of going through a converter each. Struct and array elements keep the
+	// wrapper at Owner alive, if there's one
+	static void ArrayToTable(lua_State* L, FArrayProperty* Property, void* Value, int Owner = 0);
+	static void TableToArray(lua_State* L, FArrayProperty* Property, void* Value, int Index);
+
+private:
+	static void RegisterDefaultConverters();
+
+	static TMap<FFieldClass*, FTIPropertyConverter> Converters;
+	// Converter found for each concrete property type, after walking up the FFieldClass hierarchy
+	static TMap<FFieldClass*, FTIPropertyConverter> Resolved;
+};
@@ -1,20 +1,60 @@
 #include "Script.h"
 
+#include "TIBytecodeCache.h"
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Lua/Scripting/TIScriptOrchestrator.h"
 
-FScript::FScript(FString FileName) : FileName(FileName), L(FLuaState()), State(FScriptState::NotRan)
+FScript::FScript(FString FileName, FLuaState* SharedState) : FileName(FileName), L(SharedState),
+                                                             State(FScriptState::NotRan)
 {
 	PrettyName = PrettyFilename(FileName);
+	if (!L.IsChild())
+	{
+		SetPackagePath(L.L);
+	}
+}
+
+void FScript::SetPackagePath(lua_State* L)
+{
+	// Scripts can require the other files of the config directory
+	lua_getglobal(L, LUA_LOADLIBNAME);
+	lua_getfield(L, -1, "path");
+	const FString Path = FPaths::ConvertRelativePathToFull(FTIScriptOrchestrator::GetConfigDirectory()) / TEXT("?.lua;") +
+		UTF8_TO_TCHAR(lua_tostring(L, -1));
+	lua_pop(L, 1);
+	lua_pushstring(L, TCHAR_TO_UTF8(*Path));
+	lua_setfield(L, -2, "path");
+	lua_pop(L, 1);
+}
+
+bool FScript::Load()
+{
+	if (Loaded || State != FScriptState::NotRan)
+	{
+		return Loaded;
+	}
+	FTILog::CurrentScript = PrettyName;
+	if (FTIBytecodeCache::Load(L.L, FileName, PrettyName) != LUA_OK)
+	{
+		State = FScriptState::Errored;
+		State.Payload = lua_tostring(L.L, -1);
+		LOGL(State.Payload, Error)
+	}
+	else
+	{
+		L.SetEnvironment(-1);
+		Loaded = true;
+	}
+	FTILog::CurrentScript = "";
+	return Loaded;
 }
 
 FScriptState FScript::Start()
 {
-	if (State != FScriptState::NotRan)
+	if (State != FScriptState::NotRan || !Load())
 	{
 		return State;
 	}
-	luaL_loadfile(L.L, TCHAR_TO_UTF8(*FileName));
 	return Run();
 }
 
@@ -50,13 +90,16 @@ FScriptState FScript::Run()
 			LOGFL("Discarded %d results that were yielded", Warning, NResults)
 		}
 		NewState = FScriptState::Waiting;
-		if (L.PlatformEventWaitedFor)
+		if (L.FrameWaitedFor || L.TimeWaitedFor)
 		{
-			LOG("Waiting on platform event")
-		} else
+			// Scripts spreading work over frames wait every frame
+			NewState.Payload = "Timer";
+			LOGV("Waiting on a timer")
+		}
+		else
 		{
-			NewState.Payload = L.EventWaitedFor;
-			LOGF("Waiting on %s", *L.EventWaitedFor)
+			NewState.Payload = L.EventWaitedFor.ToString();
+			LOGF("Waiting on %s", *NewState.Payload)
 		}
 	}
 	else if (Returned != LUA_OK)
@@ -66,6 +109,10 @@ FScriptState FScript::Run()
 		NewState.Payload = ErrorMsg;
 		LOGL(ErrorMsg, Error)
 	}
+	if (NewState != FScriptState::Waiting)
+	{
+		L.CommitOpenTweaks();
+	}
 	FTILog::CurrentScript = "";
 	State = NewState;
 	return NewState;
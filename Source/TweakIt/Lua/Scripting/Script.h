@@ -8,20 +8,27 @@ DECLARE_MULTICAST_DELEGATE(FScriptCompletedDelegate)
 class FScript
 {
 public:
-	explicit FScript(FString FileName);
+	// With a shared state, the script runs in a thread of it instead of its own VM
+	explicit FScript(FString FileName, FLuaState* SharedState = nullptr);
 
 	FString FileName;
 	FString PrettyName;
 	FLuaState L;
 
+	// Reads and compiles the script. Only touches this script's state, so it can run on any thread unless the state
+	// is shared
+	bool Load();
+	// Loads the script if it wasn't and runs it
 	FScriptState Start();
 	FScriptState Resume();
 
 	static FString PrettyFilename(FString ScriptFilename);
+	static void SetPackagePath(lua_State* L);
 
 	FScriptState GetState() { return State;}
 private:
 	FScriptState Run();
 	
 	FScriptState State;
+	bool Loaded = false;
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "TIBytecodeCache.h"
+
+#include "TIScriptOrchestrator.h"
+#include "HAL/FileManagerGeneric.h"
+#include "Misc/FileHelper.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "TweakIt/Logging/FTILog.h"
+
+FThreadSafeCounter FTIBytecodeCache::Hits;
+FThreadSafeCounter FTIBytecodeCache::Misses;
+
+int FTIBytecodeCache::Load(lua_State* L, const FString& FileName, const FString& PrettyName)
+{
+	const FString ChunkName = "@" + FileName;
+	TArray<uint8> Source;
+	if (!FFileHelper::LoadFileToArray(Source, *FileName))
+	{
+		lua_pushfstring(L, "cannot read %s", TCHAR_TO_UTF8(*FileName));
+		return LUA_ERRFILE;
+	}
+	FSHAHash SourceHash;
+	FSHA1::HashBuffer(Source.GetData(), Source.Num(), SourceHash.Hash);
+
+	const FString CacheFilename = GetCacheFilename(PrettyName);
+	TArray<uint8> Cached;
+	if (FFileHelper::LoadFileToArray(Cached, *CacheFilename, FILEREAD_Silent) && HeaderMatches(Cached, SourceHash))
+	{
+		const char* Bytecode = reinterpret_cast<const char*>(Cached.GetData()) + HeaderSize;
+		if (luaL_loadbufferx(L, Bytecode, Cached.Num() - HeaderSize, TCHAR_TO_UTF8(*ChunkName), "b") == LUA_OK)
+		{
+			Hits.Increment();
+			return LUA_OK;
+		}
+		LOGFL("Couldn't load the cached bytecode of %s: %s", Warning, *PrettyName, UTF8_TO_TCHAR(lua_tostring(L, -1)))
+		lua_pop(L, 1);
+	}
+	Misses.Increment();
+
+	// luaL_loadfile skips the BOM and a first line starting with #, keeping the line numbers
+	int32 Start = 0;
+	if (Source.Num() >= 3 && Source[0] == 0xEF && Source[1] == 0xBB && Source[2] == 0xBF)
+	{
+		Start = 3;
+	}
+	if (Start < Source.Num() && Source[Start] == '#')
+	{
+		while (Start < Source.Num() && Source[Start] != '\n')
+		{
+			Start++;
+		}
+	}
+	const char* Text = reinterpret_cast<const char*>(Source.GetData()) + Start;
+	const int Status = luaL_loadbufferx(L, Text, Source.Num() - Start, TCHAR_TO_UTF8(*ChunkName), "t");
+	if (Status != LUA_OK)
+	{
+		return Status;
+	}
+
+	TArray<uint8> Entry;
+	FMemoryWriter Writer(Entry);
+	uint32 EntryMagic = Magic;
+	uint32 Version = LUA_VERSION_NUM;
+	Writer << EntryMagic << Version;
+	Writer.Serialize(SourceHash.Hash, sizeof(SourceHash.Hash));
+	// Debug info is kept for error messages
+	lua_dump(L, WriterFunc, &Entry, false);
+	if (!FFileHelper::SaveArrayToFile(Entry, *CacheFilename))
+	{
+		LOGFL("Couldn't write the bytecode cache of %s to %s", Warning, *PrettyName, *CacheFilename)
+	}
+	return LUA_OK;
+}
+
+void FTIBytecodeCache::PruneStaleEntries(const TArray<FString>& PrettyNames)
+{
+	TSet<FString> Expected;
+	for (const FString& PrettyName : PrettyNames)
+	{
+		Expected.Add(FPaths::GetCleanFilename(GetCacheFilename(PrettyName)));
+	}
+	IFileManager& Manager = FFileManagerGeneric::Get();
+	TArray<FString> Entries;
+	Manager.FindFiles(Entries, *GetCacheDirectory(), TEXT(".luac"));
+	for (const FString& Entry : Entries)
+	{
+		if (!Expected.Contains(Entry))
+		{
+			Manager.Delete(*FPaths::Combine(GetCacheDirectory(), Entry));
+		}
+	}
+}
+
+void FTIBytecodeCache::ResetStats()
+{
+	Hits.Reset();
+	Misses.Reset();
+}
+
+FString FTIBytecodeCache::GetCacheDirectory()
+{
+	return FPaths::Combine(FTIScriptOrchestrator::GetConfigDirectory(), TEXT("Cache/"));
+}
+
+FString FTIBytecodeCache::GetCacheFilename(const FString& PrettyName)
+{
+	return FPaths::Combine(GetCacheDirectory(), FPaths::GetBaseFilename(PrettyName) + ".luac");
+}
+
+bool FTIBytecodeCache::HeaderMatches(const TArray<uint8>& Cached, const FSHAHash& SourceHash)
+{
+	if (Cached.Num() <= HeaderSize)
+	{
+		return false;
+	}
+	uint32 EntryMagic = 0;
+	uint32 Version = 0;
+	FSHAHash EntryHash;
+	FMemoryReader Reader(Cached);
+	Reader << EntryMagic << Version;
+	Reader.Serialize(EntryHash.Hash, sizeof(EntryHash.Hash));
+	return EntryMagic == Magic && Version == LUA_VERSION_NUM && EntryHash == SourceHash;
+}
+
+int FTIBytecodeCache::WriterFunc(lua_State* L, const void* NewData, size_t DataSize, void* Buffer)
+{
+	static_cast<TArray<uint8>*>(Buffer)->Append(static_cast<const uint8*>(NewData), DataSize);
+	return 0;
+}
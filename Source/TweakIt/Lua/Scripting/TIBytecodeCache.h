@@ -0,0 +1,29 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "TweakIt/Lua/lib/lua.hpp"
+
+// Compiled scripts, saved in the Cache folder of the config directory.
+// An entry is only used if it was compiled from the same source by the same Lua version, otherwise it gets rewritten
+class FTIBytecodeCache
+{
+public:
+	// Pushes the script's main chunk like luaL_loadfile does, or an error message. Returns the load status
+	static int Load(lua_State* L, const FString& FileName, const FString& PrettyName);
+
+	// Deletes the entries of scripts that don't exist anymore
+	static void PruneStaleEntries(const TArray<FString>& PrettyNames);
+	static void ResetStats();
+
+	static FString GetCacheDirectory();
+
+	static FThreadSafeCounter Hits;
+	static FThreadSafeCounter Misses;
+private:
+	static FString GetCacheFilename(const FString& PrettyName);
+	static bool HeaderMatches(const TArray<uint8>& Cached, const FSHAHash& SourceHash);
+	static int WriterFunc(lua_State* L, const void* NewData, size_t DataSize, void* Buffer);
+
+	// Magic, Lua version and SHA1 of the source, followed by the bytecode
+	static constexpr uint32 Magic = 0x43424954; // "TIBC"
+	static constexpr int32 HeaderSize = sizeof(uint32) * 2 + sizeof(FSHAHash::Hash);
+};
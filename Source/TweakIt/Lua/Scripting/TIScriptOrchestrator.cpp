@@ -3,12 +3,16 @@
 #include "FGGameInstance.h"
 #include "TweakIt/Lua/Lua.h"
 #include "Configuration/ConfigManager.h"
+#include "Async/ParallelFor.h"
+#include "Containers/Ticker.h"
 #include "HAL/FileManagerGeneric.h"
 #include "Module/ModModule.h"
 #include "SML/Public/Patching/NativeHookManager.h"
 #include "TweakIt/TweakItModule.h"
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Lua/Scripting/Script.h"
+#include "TweakIt/Lua/Scripting/TIBytecodeCache.h"
+#include "TweakIt/Lua/FTILuaFuncManager.h"
 
 FTIScriptOrchestrator::FTIScriptOrchestrator()
 {
@@ -18,24 +22,68 @@ FTIScriptOrchestrator::FTIScriptOrchestrator()
 		CreateDefaultScript();
 	}
 	SetupModEvents();
+	if (FParse::Param(FCommandLine::Get(), TEXT("TweakItSharedState")))
+	{
+		LOG("Scripts will share a single Lua state")
+		SharedState = MakeUnique<FLuaState>();
+		FScript::SetPackagePath(SharedState->L);
+	}
+	if (FParse::Param(FCommandLine::Get(), TEXT("TweakItWatchScripts")))
+	{
+		SetWatching(true);
+	}
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FTIScriptOrchestrator::Tick));
 }
 
 FTIScriptOrchestrator::~FTIScriptOrchestrator()
 {
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	Watcher.Reset();
 	for (auto Script : RunningScripts)
 	{
 		delete Script;
 	}
+	for (auto Script : ResidentScripts)
+	{
+		delete Script;
+	}
 }
 
 bool FTIScriptOrchestrator::StartAllScripts()
 {
 	LOG("Running all scripts")
 	bool Errored = false;
-	TArray<FString> Scripts = GetAllScripts();
-	for (FString& Filename : Scripts)
+	TArray<FString> Names = GetAllScripts();
+	// The file system doesn't guarantee an order
+	Names.Sort();
+	FTIBytecodeCache::ResetStats();
+	FTIBytecodeCache::PruneStaleEntries(Names);
+	IFileManager::Get().MakeDirectory(*FTIBytecodeCache::GetCacheDirectory(), true);
+
+	TArray<FScript*> Scripts;
+	for (const FString& Name : Names)
 	{
-		FScriptState State = StartScript(Filename);
+		Scripts.Add(PrepareScript(Name));
+	}
+	// Each job only touches its own script's state, a shared state compiles on this thread. Running stays on the game thread, in the files' order
+	const double Start = FPlatformTime::Seconds();
+	ParallelFor(Scripts.Num(), [&Scripts](int32 i)
+	{
+		if (Scripts[i])
+		{
+			Scripts[i]->Load();
+		}
+	}, SharedState.IsValid());
+	LOGF("Compiled %d scripts in %.2fms", Scripts.Num(), (FPlatformTime::Seconds() - Start) * 1000)
+	LOGF("Bytecode cache: %d hits, %d misses", FTIBytecodeCache::Hits.GetValue(), FTIBytecodeCache::Misses.GetValue())
+
+	for (int32 i = 0; i < Scripts.Num(); i++)
+	{
+		LOGF("Starting script \"%s\"", *Names[i])
+		if (!Scripts[i] || RunScript(Scripts[i], Names[i]) == FScriptState::Errored)
+		{
+			Errored = true;
+		}
 	}
 	return !Errored;
 }
@@ -55,15 +103,19 @@ void FTIScriptOrchestrator::SetupModEvents()
 	{
 		if (Reason == EModuleChangeReason::ModuleLoaded)
 		{
-			ResumeForMod(ModuleName.ToString());
+			ResumeForMod(ModuleName);
 		}
 	});
 
 	UModModule* Module = const_cast<UModModule*>(GetDefault<UModModule>());
 	SUBSCRIBE_METHOD_VIRTUAL_AFTER(UModModule::DispatchLifecycleEvent, Module, [this](UModModule* Self, ELifecyclePhase Phase)
 	{
-		FString PhaseString = StaticEnum<ELifecyclePhase>()->GetNameStringByValue(int64(Phase));
-		ResumeForMod(Self->GetOwnerModReference().ToString(), PhaseString);
+		FName& PhaseName = LifecycleNames.FindOrAdd(int64(Phase));
+		if (PhaseName.IsNone())
+		{
+			PhaseName = FName(*StaticEnum<ELifecyclePhase>()->GetNameStringByValue(int64(Phase)));
+		}
+		ResumeForMod(Self->GetOwnerModReference(), PhaseName);
 	})
 }
 
@@ -80,19 +132,64 @@ FTIScriptOrchestrator* FTIScriptOrchestrator::Get()
 FScriptState FTIScriptOrchestrator::StartScript(FString Name)
 {
 	LOGF("Starting script \"%s\"", *Name)
-	FString Path = FPaths::Combine(GetConfigDirectory(), Name);
-	if (!FPaths::FileExists(Path))
+	FScript* Script = PrepareScript(Name);
+	if (!Script)
 	{
 		FScriptState Error = FScriptState::Errored;
 		Error.Payload = "File does not exist";
 		return Error;
 	}
-	FScript* Script = new FScript(Path);
+	return RunScript(Script, Name);
+}
+
+FScript* FTIScriptOrchestrator::PrepareScript(const FString& Name)
+{
+	FString Path = FPaths::Combine(GetConfigDirectory(), Name);
+	if (!FPaths::FileExists(Path))
+	{
+		return nullptr;
+	}
+	// A rerun replaces the instances still waiting, which would otherwise keep writing through the journal
+	StopScript(Name);
+	FScript* Script = new FScript(Path, SharedState.Get());
+	// Reruns only revert what the new run doesn't change again, once it completes
+	TSharedRef<FTIChangeJournal> Journal = MakeShared<FTIChangeJournal>();
+	if (TSharedRef<FTIChangeJournal>* Previous = Journals.Find(Name))
+	{
+		Journal->Previous = *Previous;
+	}
+	Journals.Add(Name, Journal);
+	Script->L.SetJournal(Journal);
+	return Script;
+}
+
+FScriptState FTIScriptOrchestrator::RunScript(FScript* Script, const FString& Name)
+{
+	const bool Reload = Script->L.Journal->Previous.IsValid();
+	const double Start = FPlatformTime::Seconds();
 	FScriptState State = Script->Start();
 	CheckAfterScriptStop(Script);
+	if (Reload && State.IsCompleted())
+	{
+		LOGF("Reloaded \"%s\" in %.2fms", *Name, (FPlatformTime::Seconds() - Start) * 1000)
+	}
 	return State;
 }
 
+bool FTIScriptOrchestrator::RevertScript(FString Name)
+{
+	TSharedRef<FTIChangeJournal>* Journal = Journals.Find(Name);
+	if (!Journal)
+	{
+		return false;
+	}
+	StopScript(Name);
+	LOGF("Reverting %d changes of \"%s\"", (*Journal)->Num(), *Name)
+	(*Journal)->Revert();
+	Journals.Remove(Name);
+	return true;
+}
+
 FScriptState FTIScriptOrchestrator::ResumeScript(FScript* Script)
 {
 	FScriptState State = Script->Resume();
@@ -104,28 +201,165 @@ void FTIScriptOrchestrator::CheckAfterScriptStop(FScript* Script)
 {
 	if (Script->GetState().IsCompleted())
 	{
-		delete Script;
+		RecordDependencies(Script);
+		RunningScripts.Remove(Script);
+		if (Script->L.Journal.IsValid())
+		{
+			Script->L.Journal->Finish();
+		}
+		if (FTILuaFuncManager::HasHooks(&Script->L))
+		{
+			ResidentScripts.AddUnique(Script);
+		}
+		else
+		{
+			delete Script;
+		}
+		ReleaseUnhookedScripts();
 	} else
 	{
-		RunningScripts.Emplace(Script);
-		FEvent* Event = Script->L.PlatformEventWaitedFor;
-		if (Event != nullptr)
+		RunningScripts.Add(Script);
+		// Delegate waits are events named after their awaitable function
+		if (!Script->L.EventWaitedFor.IsNone())
 		{
-			FEvent* ReadyCallback = FPlatformProcess::CreateSynchEvent();
-			AsyncTask(ENamedThreads::AnyBackgroundHiPriTask, [Event, Script, this, ReadyCallback]
+			Waiters.FindOrAdd(Script->L.EventWaitedFor).AddUnique(Script);
+		}
+		else if (Script->L.FrameWaitedFor)
+		{
+			FrameTimers.HeapPush({static_cast<double>(Script->L.FrameWaitedFor), Script});
+		}
+		else if (Script->L.TimeWaitedFor)
+		{
+			TimeTimers.HeapPush({Script->L.TimeWaitedFor, Script});
+		}
+	}
+}
+
+bool FTIScriptOrchestrator::Tick(float DeltaTime)
+{
+	Frame++;
+	// Taken out first, so scripts waiting again are resumed on a later tick
+	TArray<FScript*> Due;
+	auto PopDue = [&Due](TArray<FTimer>& Timers, double Now)
+	{
+		while (Timers.Num() > 0 && Timers.HeapTop().Deadline <= Now)
+		{
+			FTimer Timer;
+			Timers.HeapPop(Timer, false);
+			Due.Add(Timer.Script);
+		}
+	};
+	PopDue(FrameTimers, Frame);
+	PopDue(TimeTimers, FPlatformTime::Seconds());
+	for (FScript* Script : Due)
+	{
+		Script->L.FrameWaitedFor = 0;
+		Script->L.TimeWaitedFor = 0;
+		ResumeScript(Script);
+	}
+	return true;
+}
+
+void FTIScriptOrchestrator::StopScript(const FString& Name)
+{
+	const FString PrettyName = FScript::PrettyFilename(FPaths::Combine(GetConfigDirectory(), Name));
+	TArray<FScript*> Stopped;
+	for (FScript* Script : RunningScripts)
+	{
+		if (Script->PrettyName == PrettyName)
+		{
+			Stopped.Add(Script);
+		}
+	}
+	if (Stopped.Num() == 0)
+	{
+		return;
+	}
+	auto IsStopped = [&Stopped](FScript* Script) { return Stopped.Contains(Script); };
+	for (auto It = Waiters.CreateIterator(); It; ++It)
+	{
+		It.Value().RemoveAll(IsStopped);
+		if (It.Value().Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+	for (TArray<FTimer>* Timers : {&FrameTimers, &TimeTimers})
+	{
+		if (Timers->RemoveAll([&IsStopped](const FTimer& Timer) { return IsStopped(Timer.Script); }) > 0)
+		{
+			Timers->Heapify();
+		}
+	}
+	for (FScript* Script : Stopped)
+	{
+		LOGF("Stopping the waiting instance of \"%s\"", *Name)
+		RunningScripts.Remove(Script);
+		delete Script;
+	}
+}
+
+void FTIScriptOrchestrator::ReleaseUnhookedScripts()
+{
+	// Rerunning a script rebinds its functions, leaving nothing to keep its last run loaded
+	for (int32 i = ResidentScripts.Num() - 1; i >= 0; i--)
+	{
+		FScript* Script = ResidentScripts[i];
+		if (!FTILuaFuncManager::HasHooks(&Script->L))
+		{
+			ResidentScripts.RemoveAt(i);
+			delete Script;
+		}
+	}
+}
+
+void FTIScriptOrchestrator::SetWatching(bool Watch)
+{
+	if (Watch && !Watcher.IsValid())
+	{
+		Watcher = MakeUnique<FTIScriptWatcher>(this);
+	}
+	else if (!Watch)
+	{
+		Watcher.Reset();
+	}
+}
+
+TArray<FString> FTIScriptOrchestrator::GetDependents(const FString& File) const
+{
+	TArray<FString> Dependents;
+	for (const auto& Script : Dependencies)
+	{
+		if (Script.Value.Contains(File))
+		{
+			Dependents.Add(Script.Key);
+		}
+	}
+	return Dependents;
+}
+
+void FTIScriptOrchestrator::RecordDependencies(FScript* Script)
+{
+	// Modules found in the config directory, by the name require got
+	TSet<FString>& Required = Dependencies.FindOrAdd(Script->PrettyName);
+	Required.Reset();
+	lua_State* L = Script->L.L;
+	Script->L.PushRequiredModules();
+	lua_pushnil(L);
+	while (lua_next(L, -2))
+	{
+		if (lua_type(L, -2) == LUA_TSTRING)
+		{
+			FString Module = UTF8_TO_TCHAR(lua_tostring(L, -2));
+			Module = Module.Replace(TEXT("."), TEXT("/")) + ".lua";
+			if (FPaths::FileExists(FPaths::Combine(GetConfigDirectory(), Module)))
 			{
-				ReadyCallback->Trigger();
-				Event->Wait();
-				AsyncTask(ENamedThreads::GameThread, [Script, this]
-				{
-					delete Script->L.PlatformEventWaitedFor;
-					Script->L.PlatformEventWaitedFor = nullptr;
-					ResumeScript(Script);
-				});
-			});
-			ReadyCallback->Wait();
+				Required.Add(Module);
+			}
 		}
+		lua_pop(L, 1);
 	}
+	lua_pop(L, 1);
 }
 
 FString FTIScriptOrchestrator::MakeEventForMod(FString ModReference, FString Lifecycle)
@@ -134,10 +368,19 @@ FString FTIScriptOrchestrator::MakeEventForMod(FString ModReference, FString Lif
 }
 
 // TODO: Make lifecycle events non-unique
-bool FTIScriptOrchestrator::ResumeForMod(FString ModReference, FString Lifecycle /* = "Module"*/)
+bool FTIScriptOrchestrator::ResumeForMod(FName ModReference, FName Lifecycle /* = "Module"*/)
+{
+	return ResumeScriptsWaitingForEvent(true, GetModEvent(ModReference, Lifecycle));
+}
+
+FName FTIScriptOrchestrator::GetModEvent(FName ModReference, FName Lifecycle)
 {
-	FString Event = MakeEventForMod(ModReference, Lifecycle);
-	return ResumeScriptsWaitingForEvent(true, Event);
+	FName& Event = ModEvents.FindOrAdd({ModReference, Lifecycle});
+	if (Event.IsNone())
+	{
+		Event = FName(*MakeEventForMod(ModReference.ToString(), Lifecycle.ToString()));
+	}
+	return Event;
 }
 
 template <typename ... T>
@@ -152,35 +395,45 @@ FString FTIScriptOrchestrator::MakeEventString(T... EventParts)
 template <typename ... T>
 bool FTIScriptOrchestrator::HasEventPassed(T... EventParts)
 {
-	FString Event = MakeEventString(EventParts...);
-	return PassedUniqueEvents.Find(Event) != INDEX_NONE;
+	return HasEventPassed(FName(*MakeEventString(EventParts...)));
 }
 
-bool FTIScriptOrchestrator::HasModPassed(FString ModReference, FString Lifecycle)
+bool FTIScriptOrchestrator::HasEventPassed(FName Event)
 {
-	return HasEventPassed(MakeEventForMod(ModReference, Lifecycle));
+	return PassedUniqueEvents.Contains(Event);
+}
+
+bool FTIScriptOrchestrator::HasModPassed(FName ModReference, FName Lifecycle)
+{
+	return HasEventPassed(GetModEvent(ModReference, Lifecycle));
 }
 
 template <typename ... T>
 bool FTIScriptOrchestrator::ResumeScriptsWaitingForEvent(bool Unique, T... EventParts)
 {
-	FString Event = MakeEventString(EventParts...);
-	// LOG(Event)
+	return ResumeScriptsWaitingForEvent(Unique, FName(*MakeEventString(EventParts...)));
+}
+
+bool FTIScriptOrchestrator::ResumeScriptsWaitingForEvent(bool Unique, FName Event)
+{
 	if (Unique)
 	{
-		PassedUniqueEvents.Emplace(Event);
+		PassedUniqueEvents.Add(Event);
+	}
+	// Taken out first, resumed scripts can wait for the same event again
+	TArray<FScript*> Scripts;
+	if (!Waiters.RemoveAndCopyValue(Event, Scripts))
+	{
+		return true;
 	}
 	bool OK = true;
-	for (auto Script : RunningScripts)
+	for (auto Script : Scripts)
 	{
-		if (Script->L.EventWaitedFor == Event)
+		Script->L.EventWaitedFor = NAME_None;
+		FScriptState State = ResumeScript(Script);
+		if (State == FScriptState::Errored)
 		{
-			Script->L.EventWaitedFor = "";
-			FScriptState State = ResumeScript(Script);
-			if (State == FScriptState::Errored)
-			{
-				OK = false;
-			}
+			OK = false;
 		}
 	}
 	return OK;
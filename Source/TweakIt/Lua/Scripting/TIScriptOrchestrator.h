@@ -2,6 +2,7 @@
 
 #include "FGSubsystem.h"
 #include "TweakIt/Lua/Scripting/Script.h"
+#include "TweakIt/Lua/Scripting/TIScriptWatcher.h"
 
 class FTIScriptOrchestrator
 {
@@ -11,8 +12,18 @@ public:
 	
 	bool StartAllScripts();
 	FScriptState StartScript(FString Name);
+	// Undoes the property changes of the script's last run. Returns false if it has none
+	bool RevertScript(FString Name);
 	FScriptState ResumeScript(FScript* Script);
+	// Deletes the instances of the script that are still waiting, without resuming them
+	void StopScript(const FString& Name);
 	void CheckAfterScriptStop(FScript* Script);
+
+	// Reruns scripts when their file or a file they require changes
+	void SetWatching(bool Watch);
+	bool IsWatching() const { return Watcher.IsValid(); }
+	// Scripts that required the given file in their last run
+	TArray<FString> GetDependents(const FString& File) const;
 	
 	
 	static FString MakeEventForMod(FString ModReference, FString Lifecycle = "Module");
@@ -21,12 +32,18 @@ public:
 	
 	template<typename... T>
 	bool HasEventPassed(T... EventParts);
-	bool HasModPassed(FString ModReference, FString Lifecycle = "Module");
+	bool HasEventPassed(FName Event);
+	bool HasModPassed(FName ModReference, FName Lifecycle = "Module");
 
-	bool ResumeForMod(FString ModReference, FString Lifecycle = "Module");
+	bool ResumeForMod(FName ModReference, FName Lifecycle = "Module");
 
 	template<typename... T>
 	bool ResumeScriptsWaitingForEvent(bool Unique, T... EventParts);
+	// Only touches the scripts waiting for the event
+	bool ResumeScriptsWaitingForEvent(bool Unique, FName Event);
+
+	// Frames ticked since the orchestrator was created, what WaitFrames counts in
+	uint64 GetFrame() const { return Frame; }
 
 	static TArray<FString> GetAllScripts();
 	
@@ -34,8 +51,47 @@ public:
 	static FTIScriptOrchestrator* Get();
 private:
 	static void CreateDefaultScript();
+	// Creates the script and its journal, or returns nullptr if the file doesn't exist
+	FScript* PrepareScript(const FString& Name);
+	FScriptState RunScript(FScript* Script, const FString& Name);
 	void SetupModEvents();
+	// The event of a mod's lifecycle phase, built once per mod and phase
+	FName GetModEvent(FName ModReference, FName Lifecycle);
+	// Records the modules from the config directory a completed script required, reloading it when they change
+	void RecordDependencies(FScript* Script);
+	// Deletes the resident scripts whose functions were all bound again by other scripts
+	void ReleaseUnhookedScripts();
+	// Resumes the scripts whose Sleep or WaitFrames is over
+	bool Tick(float DeltaTime);
 	
-	TArray<FScript*> RunningScripts;
-	TArray<FString> PassedUniqueEvents;
+	TSet<FScript*> RunningScripts;
+	// Completed scripts whose Lua functions are still bound to UFunctions
+	TArray<FScript*> ResidentScripts;
+	TSet<FName> PassedUniqueEvents;
+	TMap<TPair<FName, FName>, FName> ModEvents;
+	// Lifecycle phase names, by the phase's value
+	TMap<int64, FName> LifecycleNames;
+	// Running scripts that yielded in WaitForEvent, by the event they wait for
+	TMap<FName, TArray<FScript*>> Waiters;
+	// The changes of each script's last run, by script name
+	TMap<FString, TSharedRef<FTIChangeJournal>> Journals;
+	// The files of the config directory each script required, by script name
+	TMap<FString, TSet<FString>> Dependencies;
+	TUniquePtr<FTIScriptWatcher> Watcher;
+	// With -TweakItSharedState, the VM every script runs in
+	TUniquePtr<FLuaState> SharedState;
+
+	struct FTimer
+	{
+		// A frame or a time, depending on the heap
+		double Deadline;
+		FScript* Script;
+
+		bool operator<(const FTimer& Other) const { return Deadline < Other.Deadline; }
+	};
+	// Min-heaps of the scripts waiting in WaitFrames and Sleep, a tick only looks at the ones that are due
+	TArray<FTimer> FrameTimers;
+	TArray<FTimer> TimeTimers;
+	uint64 Frame = 0;
+	FDelegateHandle TickerHandle;
 };
@@ -0,0 +1,196 @@
+#include "TIScriptWatcher.h"
+
+#include "TIScriptOrchestrator.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManagerGeneric.h"
+#include "TweakIt/Logging/FTILog.h"
+
+#if PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FTIScriptWatcher::FTIScriptWatcher(FTIScriptOrchestrator* Orchestrator) : Orchestrator(Orchestrator)
+{
+	Directory = FPaths::ConvertRelativePathToFull(FTIScriptOrchestrator::GetConfigDirectory());
+#if PLATFORM_LINUX
+	InotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (InotifyDescriptor >= 0 && !AddWatches(TEXT("")))
+	{
+		close(InotifyDescriptor);
+		InotifyDescriptor = -1;
+	}
+	if (InotifyDescriptor < 0)
+	{
+		LOGFL("Couldn't watch %s with inotify, falling back to polling", Warning, *Directory)
+	}
+#endif
+	if (InotifyDescriptor < 0)
+	{
+		SnapshotTimestamps(Timestamps);
+	}
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FTIScriptWatcher::Tick), 0.1f);
+	LOGF("Watching %s for script changes", *Directory)
+}
+
+FTIScriptWatcher::~FTIScriptWatcher()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+#if PLATFORM_LINUX
+	if (InotifyDescriptor >= 0)
+	{
+		close(InotifyDescriptor);
+	}
+#endif
+	LOG("Stopped watching for script changes")
+}
+
+bool FTIScriptWatcher::Tick(float DeltaTime)
+{
+	Poll();
+	ReloadSettled();
+	return true;
+}
+
+void FTIScriptWatcher::Poll()
+{
+	const double Now = FPlatformTime::Seconds();
+#if PLATFORM_LINUX
+	if (InotifyDescriptor >= 0)
+	{
+		alignas(inotify_event) char Buffer[4096];
+		ssize_t Length;
+		while ((Length = read(InotifyDescriptor, Buffer, sizeof(Buffer))) > 0)
+		{
+			for (char* Event = Buffer; Event < Buffer + Length;)
+			{
+				const inotify_event* Notification = reinterpret_cast<inotify_event*>(Event);
+				const FString Name = Notification->len > 0
+					                     ? FPaths::Combine(WatchedDirectories.FindRef(Notification->wd),
+					                                       UTF8_TO_TCHAR(Notification->name))
+					                     : TEXT("");
+				if (Notification->mask & IN_IGNORED)
+				{
+					WatchedDirectories.Remove(Notification->wd);
+				}
+				else if (Notification->mask & IN_ISDIR)
+				{
+					if (Notification->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						AddWatches(Name);
+					}
+				}
+				else if (Name.EndsWith(TEXT(".lua")))
+				{
+					Pending.Add(Name, Now);
+				}
+				Event += sizeof(inotify_event) + Notification->len;
+			}
+		}
+		return;
+	}
+#endif
+	if (Now < NextPoll)
+	{
+		return;
+	}
+	NextPoll = Now + PollInterval;
+	TMap<FString, FDateTime> Current;
+	SnapshotTimestamps(Current);
+	for (const auto& Script : Current)
+	{
+		const FDateTime* Previous = Timestamps.Find(Script.Key);
+		if (!Previous || *Previous != Script.Value)
+		{
+			Pending.Add(Script.Key, Now);
+		}
+	}
+	for (const auto& Script : Timestamps)
+	{
+		if (!Current.Contains(Script.Key))
+		{
+			Pending.Add(Script.Key, Now);
+		}
+	}
+	Timestamps = MoveTemp(Current);
+}
+
+void FTIScriptWatcher::SnapshotTimestamps(TMap<FString, FDateTime>& OutTimestamps) const
+{
+	IFileManager& Manager = FFileManagerGeneric::Get();
+	TArray<FString> Files;
+	Manager.FindFilesRecursive(Files, *Directory, TEXT("*.lua"), true, false);
+	for (const FString& File : Files)
+	{
+		OutTimestamps.Add(File.RightChop(Directory.Len() + 1), Manager.GetTimeStamp(*File));
+	}
+}
+
+bool FTIScriptWatcher::AddWatches(const FString& Relative)
+{
+#if PLATFORM_LINUX
+	const FString Path = FPaths::Combine(Directory, Relative);
+	const int Watch = inotify_add_watch(InotifyDescriptor, TCHAR_TO_UTF8(*Path),
+	                                    IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE);
+	if (Watch < 0)
+	{
+		return false;
+	}
+	WatchedDirectories.Add(Watch, Relative);
+	TArray<FString> Subdirectories;
+	FFileManagerGeneric::Get().FindFiles(Subdirectories, *FPaths::Combine(Path, TEXT("*")), false, true);
+	for (const FString& Subdirectory : Subdirectories)
+	{
+		AddWatches(FPaths::Combine(Relative, Subdirectory));
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FTIScriptWatcher::ReloadSettled()
+{
+	const double Now = FPlatformTime::Seconds();
+	TArray<FString> Settled;
+	for (const auto& Change : Pending)
+	{
+		if (Now - Change.Value >= DebounceSeconds)
+		{
+			Settled.Add(Change.Key);
+		}
+	}
+	if (Settled.Num() == 0)
+	{
+		return;
+	}
+	TArray<FString> Reloaded;
+	for (const FString& Changed : Settled)
+	{
+		const double Seen = Pending.FindAndRemoveChecked(Changed);
+		TArray<FString> Scripts = Orchestrator->GetDependents(Changed);
+		// Files in subdirectories are only modules
+		if (!Changed.Contains(TEXT("/")))
+		{
+			Scripts.AddUnique(Changed);
+		}
+		for (const FString& Script : Scripts)
+		{
+			if (Reloaded.Contains(Script))
+			{
+				continue;
+			}
+			Reloaded.Add(Script);
+			if (FPaths::FileExists(FPaths::Combine(Directory, Script)))
+			{
+				Orchestrator->StartScript(Script);
+			}
+			else
+			{
+				Orchestrator->RevertScript(Script);
+			}
+			LOGF("Reloaded \"%s\" after a change to \"%s\", %.2fms after the change was seen", *Script, *Changed,
+			     (FPlatformTime::Seconds() - Seen) * 1000)
+		}
+	}
+}
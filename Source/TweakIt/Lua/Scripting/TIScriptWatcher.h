@@ -0,0 +1,39 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class FTIScriptOrchestrator;
+
+// Reruns scripts when they change on disk, along with the scripts requiring them. Deleted scripts are reverted.
+// Modules in subdirectories are watched too, only the scripts requiring them are rerun.
+// Uses inotify on Linux and compares modification times elsewhere. Changes are debounced since editors
+// often write a file several times when saving
+class FTIScriptWatcher
+{
+public:
+	explicit FTIScriptWatcher(FTIScriptOrchestrator* Orchestrator);
+	~FTIScriptWatcher();
+	UE_NONCOPYABLE(FTIScriptWatcher)
+
+private:
+	bool Tick(float DeltaTime);
+	// Adds the changed scripts to Pending
+	void Poll();
+	void SnapshotTimestamps(TMap<FString, FDateTime>& OutTimestamps) const;
+	// Watches the directory, relative to Directory, and the ones below it. False if the directory couldn't be watched
+	bool AddWatches(const FString& Relative);
+	void ReloadSettled();
+
+	FTIScriptOrchestrator* Orchestrator;
+	FString Directory;
+	FDelegateHandle TickerHandle;
+	// Script name to the time its last change was seen
+	TMap<FString, double> Pending;
+	TMap<FString, FDateTime> Timestamps;
+	double NextPoll = 0;
+	int InotifyDescriptor = -1;
+	// Inotify watch descriptor to the directory it watches, relative to Directory
+	TMap<int, FString> WatchedDirectories;
+
+	static constexpr double PollInterval = 0.5;
+	static constexpr double DebounceSeconds = 0.3;
+};
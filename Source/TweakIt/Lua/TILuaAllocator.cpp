@@ -0,0 +1,130 @@
+#include "TILuaAllocator.h"
+
+#include "TweakIt/Logging/FTILog.h"
+
+FTILuaAllocator::FTILuaAllocator()
+{
+	static const uint64 DefaultLimit = []
+	{
+		uint64 Megabytes = 0;
+		FParse::Value(FCommandLine::Get(), TEXT("TweakItMemoryLimitMB="), Megabytes);
+		return Megabytes * 1024 * 1024;
+	}();
+	Limit = DefaultLimit;
+}
+
+FTILuaAllocator::~FTILuaAllocator()
+{
+	for (void* Page : Pages)
+	{
+		FMemory::Free(Page);
+	}
+}
+
+void* FTILuaAllocator::Alloc(void* Userdata, void* Block, size_t OldSize, size_t NewSize)
+{
+	FTILuaAllocator* Self = static_cast<FTILuaAllocator*>(Userdata);
+	if (NewSize == 0)
+	{
+		if (Block)
+		{
+			Self->Free(Block, OldSize);
+		}
+		return nullptr;
+	}
+	// Without a block, Lua passes the type of the new object instead of a size
+	const size_t Old = Block ? OldSize : 0;
+	if (Self->Limit && NewSize > Old && Self->Bytes + (NewSize - Old) > Self->Limit)
+	{
+		if (!Self->ReportedLimit)
+		{
+			LOGFL("A Lua state reached its memory limit of %llu bytes", Warning, Self->Limit)
+			Self->ReportedLimit = true;
+		}
+		return nullptr;
+	}
+	if (!Block)
+	{
+		return Self->Allocate(NewSize);
+	}
+	if (IsSmall(Old) && IsSmall(NewSize) && ClassOf(Old) == ClassOf(NewSize))
+	{
+		Self->Account(static_cast<int64>(NewSize) - static_cast<int64>(Old));
+		return Block;
+	}
+	if (!IsSmall(Old) && !IsSmall(NewSize))
+	{
+		void* Moved = FMemory::Realloc(Block, NewSize);
+		if (Moved)
+		{
+			Self->Account(static_cast<int64>(NewSize) - static_cast<int64>(Old));
+		}
+		return Moved;
+	}
+	void* Moved = Self->Allocate(NewSize);
+	if (Moved)
+	{
+		FMemory::Memcpy(Moved, Block, FMath::Min(Old, NewSize));
+		Self->Free(Block, Old);
+	}
+	return Moved;
+}
+
+void* FTILuaAllocator::Allocate(size_t Size)
+{
+	void* Block;
+	if (IsSmall(Size))
+	{
+		const int32 Class = ClassOf(Size);
+		if (!FreeLists[Class])
+		{
+			Refill(Class);
+		}
+		FFreeBlock* Head = FreeLists[Class];
+		FreeLists[Class] = Head->Next;
+		Block = Head;
+	}
+	else
+	{
+		Block = FMemory::Malloc(Size);
+	}
+	Allocations++;
+	Account(Size);
+	return Block;
+}
+
+void FTILuaAllocator::Free(void* Block, size_t Size)
+{
+	if (IsSmall(Size))
+	{
+		FFreeBlock* Freed = static_cast<FFreeBlock*>(Block);
+		const int32 Class = ClassOf(Size);
+		Freed->Next = FreeLists[Class];
+		FreeLists[Class] = Freed;
+	}
+	else
+	{
+		FMemory::Free(Block);
+	}
+	Account(-static_cast<int64>(Size));
+}
+
+void FTILuaAllocator::Refill(int32 Class)
+{
+	const size_t BlockSize = (Class + 1) * Granularity;
+	uint8* Page = static_cast<uint8*>(FMemory::Malloc(PageSize, Granularity));
+	Pages.Add(Page);
+	// Blocks are handed out from the start of the page
+	for (size_t Offset = PageSize - PageSize % BlockSize; Offset >= BlockSize; Offset -= BlockSize)
+	{
+		FFreeBlock* Block = reinterpret_cast<FFreeBlock*>(Page + Offset - BlockSize);
+		Block->Next = FreeLists[Class];
+		FreeLists[Class] = Block;
+	}
+}
+
+void FTILuaAllocator::Account(int64 Delta)
+{
+	Bytes += Delta;
+	PeakBytes = FMath::Max(PeakBytes, Bytes);
+}
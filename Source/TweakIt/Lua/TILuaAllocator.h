@@ -0,0 +1,46 @@
+#pragma once
+#include "CoreMinimal.h"
+
+// Allocator of a Lua state. Blocks up to MaxSmallSize come from per size class free lists carved out of pages,
+// bigger ones from FMemory. Counts what the state uses, and can refuse to grow past a limit, which Lua
+// raises as a memory error. Only used by its state's thread
+class FTILuaAllocator
+{
+public:
+	FTILuaAllocator();
+	~FTILuaAllocator();
+	UE_NONCOPYABLE(FTILuaAllocator)
+
+	// lua_Alloc, Userdata being the allocator
+	static void* Alloc(void* Userdata, void* Block, size_t OldSize, size_t NewSize);
+
+	// Bytes requested by Lua, not counting size class rounding and free blocks
+	uint64 Bytes = 0;
+	uint64 PeakBytes = 0;
+	uint64 Allocations = 0;
+	// 0 for no limit. Defaults to -TweakItMemoryLimitMB=
+	uint64 Limit = 0;
+
+private:
+	void* Allocate(size_t Size);
+	void Free(void* Block, size_t Size);
+	void Refill(int32 Class);
+	void Account(int64 Delta);
+
+	static bool IsSmall(size_t Size) { return Size <= MaxSmallSize; }
+	static int32 ClassOf(size_t Size) { return static_cast<int32>((Size - 1) / Granularity); }
+
+	static constexpr size_t Granularity = 16;
+	static constexpr size_t MaxSmallSize = 256;
+	static constexpr int32 NumClasses = MaxSmallSize / Granularity;
+	static constexpr size_t PageSize = 16 * 1024;
+
+	struct FFreeBlock
+	{
+		FFreeBlock* Next;
+	};
+
+	FFreeBlock* FreeLists[NumClasses] = {};
+	TArray<void*> Pages;
+	bool ReportedLimit = false;
+};
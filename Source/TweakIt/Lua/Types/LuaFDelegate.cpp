@@ -7,6 +7,7 @@
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Lua/FTILuaFuncManager.h"
 #include "TweakIt/Lua/LuaState.h"
+#include "TweakIt/Lua/Scripting/TIScriptOrchestrator.h"
 using namespace std;
 
 FLuaFDelegate::FLuaFDelegate(UFunction* Signature, FScriptDelegate* Delegate) : SignatureFunction(Signature), Delegate(Delegate)
@@ -22,24 +23,16 @@ int FLuaFDelegate::Construct(lua_State* L, UFunction* SignatureFunction, FScript
 		lua_pushnil(L);
 		return 1;
 	}
-	LOG("Constructing a LuaFDelegate")
-	FLuaFDelegate** ReturnedInstance = static_cast<FLuaFDelegate**>(lua_newuserdata(L, sizeof(FLuaFDelegate*)));
-	*ReturnedInstance = new FLuaFDelegate(SignatureFunction, Delegate);
-	luaL_getmetatable(L, FLuaFDelegate::Name);
-	lua_setmetatable(L, -2);
+	LOGT("Constructing a LuaFDelegate")
+	FLuaFDelegate* Instance = FTILua::LuaT_NewUserdata<FLuaFDelegate>(L, SignatureFunction, Delegate);
+	Instance->ReferenceHandle = FLuaState::Get(L)->AddReference(Instance->SignatureFunction);
+	Instance->DelegateReferenceHandle = FLuaState::Get(L)->AddDelegateReference(Instance->Delegate);
 	return 1;
 }
 
 FLuaFDelegate* FLuaFDelegate::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaFDelegate**>(luaL_checkudata(L, Index, Name));
-}
-
-void FLuaFDelegate::AddReferencedObjects(FReferenceCollector& Collector)
-{
-	Collector.AddReferencedObject(SignatureFunction);
-	UObject* Object = Delegate->GetUObject();
-	Collector.AddReferencedObject(Object);
+	return static_cast<FLuaFDelegate*>(luaL_checkudata(L, Index, Name));
 }
 
 FString FLuaFDelegate::ToString() const
@@ -88,9 +81,12 @@ int FLuaFDelegate::Lua_Wait(lua_State* L)
 {
 	FLuaFDelegate* Self = Get(L);
 	FName FunctionName = "";
-	FEvent* Event =  UTIUFunctionBinder::MakeAwaitableFunction(FunctionName);
+	UTIUFunctionBinder::MakeAwaitableFunction(FunctionName, [](FName Event)
+	{
+		FTIScriptOrchestrator::Get()->ResumeScriptsWaitingForEvent(false, Event);
+	});
 	Self->Delegate->BindUFunction(UTIUFunctionBinder::Get(), FunctionName);
-	FLuaState::Get(L)->PlatformEventWaitedFor = Event;
+	FLuaState::Get(L)->EventWaitedFor = FunctionName;
 	lua_yield(L, 0);
 	return 0;
 }
@@ -118,7 +114,7 @@ int FLuaFDelegate::Lua__index(lua_State* L)
 {
 	FLuaFDelegate* Self = Get(L);
 	const FString Index = luaL_checkstring(L, 2);
-	LOGF("Indexing a LuaFDelegate %s with %s", *Self->ToString(),*Index)
+	LOGFT("Indexing a LuaFDelegate %s with %s", *Self->ToString(),*Index)
 	if (lua_CFunction* Method = Methods.Find(Index))
 	{
 		lua_pushcfunction(L, *Method);
@@ -143,7 +139,9 @@ int FLuaFDelegate::Lua__tostring(lua_State* L)
 int FLuaFDelegate::Lua__gc(lua_State* L)
 {
 	FLuaFDelegate* Self = Get(L);
-	delete Self;
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	FLuaState::Get(L)->RemoveDelegateReference(Self->DelegateReferenceHandle);
+	Self->~FLuaFDelegate();
 	return 0;
 }
 
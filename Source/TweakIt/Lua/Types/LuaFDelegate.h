@@ -3,18 +3,18 @@
 
 #include "TweakIt/Lua/Lua.h"
 
-struct FLuaFDelegate : FGCObject
+struct FLuaFDelegate
 {
 	FLuaFDelegate(UFunction* Signature, FScriptDelegate* Delegate);
 	
 	UFunction* SignatureFunction;
+	int32 ReferenceHandle = INDEX_NONE;
+	int32 DelegateReferenceHandle = INDEX_NONE;
 	// TODO: Handle possible collection/removal
 	FScriptDelegate* Delegate;
 	
 	static int Construct(lua_State* L, UFunction* SignatureFunction, FScriptDelegate* Delegate);
 	static FLuaFDelegate* Get(lua_State* L, int Index = 1);
-
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
 	
 	FString ToString() const;
 
@@ -9,6 +9,7 @@
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Lua/FTILuaFuncManager.h"
 #include "TweakIt/Lua/LuaState.h"
+#include "TweakIt/Lua/Scripting/TIScriptOrchestrator.h"
 using namespace std;
 
 FLuaFMulticastDelegate::FLuaFMulticastDelegate(UFunction* Signature, FMulticastScriptDelegate* Delegate) : SignatureFunction(Signature), Delegate(Delegate)
@@ -24,22 +25,15 @@ int FLuaFMulticastDelegate::Construct(lua_State* L, UFunction* SignatureFunction
 		lua_pushnil(L);
 		return 1;
 	}
-	LOG("Constructing a LuaFDelegate")
-	FLuaFMulticastDelegate** ReturnedInstance = static_cast<FLuaFMulticastDelegate**>(lua_newuserdata(L, sizeof(FLuaFMulticastDelegate*)));
-	*ReturnedInstance = new FLuaFMulticastDelegate(SignatureFunction, Delegate);
-	luaL_getmetatable(L, FLuaFMulticastDelegate::Name);
-	lua_setmetatable(L, -2);
+	LOGT("Constructing a LuaFDelegate")
+	FLuaFMulticastDelegate* Instance = FTILua::LuaT_NewUserdata<FLuaFMulticastDelegate>(L, SignatureFunction, Delegate);
+	Instance->ReferenceHandle = FLuaState::Get(L)->AddReference(Instance->SignatureFunction);
 	return 1;
 }
 
 FLuaFMulticastDelegate* FLuaFMulticastDelegate::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaFMulticastDelegate**>(luaL_checkudata(L, Index, Name));
-}
-
-void FLuaFMulticastDelegate::AddReferencedObjects(FReferenceCollector& Collector)
-{
-	Collector.AddReferencedObject(SignatureFunction);
+	return static_cast<FLuaFMulticastDelegate*>(luaL_checkudata(L, Index, Name));
 }
 
 FString FLuaFMulticastDelegate::ToString() const
@@ -59,12 +53,8 @@ int FLuaFMulticastDelegate::Lua_Add(lua_State* L)
 	LOG("Copying UFunction")
 	UFunction* Function = FTIReflection::CopyUFunction(Self->SignatureFunction, FunctionName);
 	FunctionName = Function->GetFullName();
-	LOG("Dumping Lua func")
-	FTILuaFuncManager::DumpFunction(L, FunctionName, 2);
-	LOG("Making native func from lua func")
-	FNativeFuncPtr Func = FTILuaFuncManager::SavedLuaFuncToNativeFunc(L, FunctionName);
-	LOG("Setting native func")
-	Function->SetNativeFunc(Func);
+	LOG("Binding Lua func")
+	FTILuaFuncManager::BindLuaFunction(L, Function, 2);
 	LOG("Adding function")
 	UTIUFunctionBinder::AddFunction(Function, FName(FunctionName));
 	LOG("Binding function")
@@ -100,11 +90,14 @@ int FLuaFMulticastDelegate::Lua_Wait(lua_State* L)
 	FLuaFMulticastDelegate* Self = Get(L);
 	FName FunctionName = FName(UTIUFunctionBinder::MakeFunctionName(""));
 	LOG(FunctionName)
-	FEvent* Event =  UTIUFunctionBinder::MakeAwaitableFunction(FunctionName);
+	UTIUFunctionBinder::MakeAwaitableFunction(FunctionName, [](FName Event)
+	{
+		FTIScriptOrchestrator::Get()->ResumeScriptsWaitingForEvent(false, Event);
+	});
 	FScriptDelegate Delegate = FScriptDelegate();
 	Delegate.BindUFunction(UTIUFunctionBinder::Get(), FunctionName);
 	Self->Delegate->Add(Delegate);
-	FLuaState::Get(L)->PlatformEventWaitedFor = Event;
+	FLuaState::Get(L)->EventWaitedFor = FunctionName;
 	lua_yield(L, 0);
 	return 0;
 }
@@ -148,7 +141,7 @@ int FLuaFMulticastDelegate::Lua__index(lua_State* L)
 {
 	FLuaFMulticastDelegate* Self = Get(L);
 	const FString Index = luaL_checkstring(L, 2);
-	LOGF("Indexing a LuaFDelegate %s with %s", *Self->ToString(),*Index)
+	LOGFT("Indexing a LuaFDelegate %s with %s", *Self->ToString(),*Index)
 	if (lua_CFunction* Method = Methods.Find(Index))
 	{
 		lua_pushcfunction(L, *Method);
@@ -173,7 +166,8 @@ int FLuaFMulticastDelegate::Lua__tostring(lua_State* L)
 int FLuaFMulticastDelegate::Lua__gc(lua_State* L)
 {
 	FLuaFMulticastDelegate* Self = Get(L);
-	delete Self;
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	Self->~FLuaFMulticastDelegate();
 	return 0;
 }
 
@@ -3,18 +3,17 @@
 
 #include "TweakIt/Lua/Lua.h"
 
-struct FLuaFMulticastDelegate : FGCObject
+struct FLuaFMulticastDelegate
 {
 	FLuaFMulticastDelegate(UFunction* Signature, FMulticastScriptDelegate* Delegate);
 	
 	UFunction* SignatureFunction;
+	int32 ReferenceHandle = INDEX_NONE;
 	// TODO: Handle possible collection/removal
 	FMulticastScriptDelegate* Delegate;
 	
 	static int Construct(lua_State* L, UFunction* SignatureFunction, FMulticastScriptDelegate* Delegate);
 	static FLuaFMulticastDelegate* Get(lua_State* L, int Index = 1);
-
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
 	
 	FString ToString() const;
 
@@ -0,0 +1,143 @@
+#include "LuaObjectIterator.h"
+
+#include "LuaUObject.h"
+#include "TweakIt/Helpers/TIReflection.h"
+#include "TweakIt/Logging/FTILog.h"
+#include "TweakIt/Lua/LuaState.h"
+#include "UObject/UObjectHash.h"
+
+FLuaObjectIterator::FLuaObjectIterator(UClass* Class) : Class(Class)
+{
+	TArray<UClass*> Derived;
+	GetDerivedClasses(Class, Derived);
+	Classes.Add(Class);
+	Classes.Append(Derived);
+}
+
+void FLuaObjectIterator::ReadFilters(lua_State* L, int Index)
+{
+	Index = lua_absindex(L, Index);
+	if (lua_getfield(L, Index, "Outer") != LUA_TNIL)
+	{
+		Outer = FLuaUObject::Get(L, -1)->Object;
+	}
+	lua_pop(L, 1);
+	if (lua_getfield(L, Index, "World") != LUA_TNIL)
+	{
+		// Any object of the world will do
+		UObject* Context = FLuaUObject::Get(L, -1)->Object;
+		World = Cast<UWorld>(Context);
+		if (!World.IsValid())
+		{
+			World = Context->GetWorld();
+		}
+	}
+	lua_pop(L, 1);
+	if (lua_getfield(L, Index, "Flags") != LUA_TNIL)
+	{
+		Flags = static_cast<EObjectFlags>(luaL_checkinteger(L, -1));
+	}
+	lua_pop(L, 1);
+	if (lua_getfield(L, Index, "Where") == LUA_TTABLE)
+	{
+		lua_pushnil(L);
+		while (lua_next(L, -2))
+		{
+			const char* PropertyName = luaL_checkstring(L, -2);
+			FProperty* Property = FTIReflection::FindPropertyByName(Class, UTF8_TO_TCHAR(PropertyName));
+			if (!Property)
+			{
+				luaL_error(L, "%s has no property %s", TCHAR_TO_UTF8(*Class->GetName()), PropertyName);
+			}
+			TUniquePtr<FTIPropertyPredicate> Predicate = FTIPropertyPredicate::Make({Property}, ETIComparison::Equal, L, -1);
+			if (!Predicate)
+			{
+				lua_error(L);
+			}
+			Where.Add(MoveTemp(Predicate));
+			lua_pop(L, 1);
+		}
+	}
+	lua_pop(L, 1);
+}
+
+bool FLuaObjectIterator::Matches(UObject* Object) const
+{
+	if (Outer.IsValid() && !Object->IsIn(Outer.Get()))
+	{
+		return false;
+	}
+	if (World.IsValid() && Object->GetWorld() != World.Get())
+	{
+		return false;
+	}
+	if (!Object->HasAllFlags(Flags))
+	{
+		return false;
+	}
+	for (const TUniquePtr<FTIPropertyPredicate>& Predicate : Where)
+	{
+		if (!Predicate->Matches(Object))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int FLuaObjectIterator::ConstructIterator(lua_State* L, UClass* Class)
+{
+	LOGFT("Constructing an object iterator for %s", *Class->GetName())
+	FLuaObjectIterator* Instance = FTILua::LuaT_NewUserdata<FLuaObjectIterator>(L, Class);
+	Instance->ReferenceHandle = FLuaState::Get(L)->AddReference(Instance->Class);
+	return 1;
+}
+
+FLuaObjectIterator* FLuaObjectIterator::Get(lua_State* L, int Index)
+{
+	return static_cast<FLuaObjectIterator*>(luaL_checkudata(L, Index, Name));
+}
+
+// Called by the generic for, returns the next matching object or nil once done
+int FLuaObjectIterator::Lua__call(lua_State* L)
+{
+	FLuaObjectIterator* Self = Get(L);
+	while (true)
+	{
+		while (Self->NextObject < Self->Objects.Num())
+		{
+			UObject* Object = Self->Objects[Self->NextObject++].Get();
+			if (Object && !Object->IsPendingKill() && Self->Matches(Object))
+			{
+				FLuaUObject::ConstructObject(L, Object);
+				return 1;
+			}
+		}
+		if (Self->NextClass >= Self->Classes.Num())
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+		Self->Objects.Reset();
+		Self->NextObject = 0;
+		if (UClass* Next = Self->Classes[Self->NextClass++].Get())
+		{
+			TArray<UObject*> Found;
+			GetObjectsOfClass(Next, Found, false, RF_ClassDefaultObject, EInternalObjectFlags::PendingKill);
+			Self->Objects.Append(Found);
+		}
+	}
+}
+
+int FLuaObjectIterator::Lua__gc(lua_State* L)
+{
+	FLuaObjectIterator* Self = Get(L);
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	Self->~FLuaObjectIterator();
+	return 0;
+}
+
+void FLuaObjectIterator::RegisterMetadata(lua_State* L)
+{
+	FTILua::RegisterMetatable(L, Name, Metadata);
+}
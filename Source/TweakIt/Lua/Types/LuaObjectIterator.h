@@ -0,0 +1,45 @@
+#pragma once
+#include "CoreMinimal.h"
+
+#include "TweakIt/Helpers/TIPropertyPredicate.h"
+#include "TweakIt/Lua/Lua.h"
+
+// Objects of a class and its subclasses, gathered from the object hash one class at a time as the loop goes.
+// Objects are filtered before they get a Lua wrapper
+struct FLuaObjectIterator
+{
+	FLuaObjectIterator(UClass* Class);
+
+	UClass* Class;
+	int32 ReferenceHandle = INDEX_NONE;
+
+	// Filters, all of them have to match
+	TWeakObjectPtr<UObject> Outer;
+	TWeakObjectPtr<UWorld> World;
+	EObjectFlags Flags = RF_NoFlags;
+	TArray<TUniquePtr<FTIPropertyPredicate>> Where;
+
+	// Reads {Outer, World, Flags, Where = {Property = Value}} from the table at Index
+	void ReadFilters(lua_State* L, int Index);
+	bool Matches(UObject* Object) const;
+
+	static int ConstructIterator(lua_State* L, UClass* Class);
+	static FLuaObjectIterator* Get(lua_State* L, int Index = 1);
+
+	static int Lua__call(lua_State* L);
+	static int Lua__gc(lua_State* L);
+
+	static void RegisterMetadata(lua_State* L);
+	inline static const char* Name = "ObjectIterator";
+
+private:
+	TArray<TWeakObjectPtr<UClass>> Classes;
+	int32 NextClass = 0;
+	TArray<TWeakObjectPtr<UObject>> Objects;
+	int32 NextObject = 0;
+
+	inline static TArray<luaL_Reg> Metadata = {
+		{"__call", Lua__call},
+		{"__gc", Lua__gc},
+	};
+};
@@ -3,14 +3,16 @@
 #include <string>
 
 #include "TweakIt/Logging/FTILog.h"
+#include "TweakIt/Lua/LuaState.h"
 using namespace std;
 
-FLuaTArray::FLuaTArray(FArrayProperty* Property, void* Container) : ArrayProperty(Property), Container(Container)
+FLuaTArray::FLuaTArray(FArrayProperty* Property, void* Value) : ArrayProperty(Property), Value(static_cast<FScriptArray*>(Value)), Owner(Property->GetOwnerUObject()),
+	InnerConverter(FTIPropertyMarshaller::GetConverter(Property->Inner))
 {
 	
 }
 
-int FLuaTArray::ConstructArray(lua_State* L, FArrayProperty* ArrayProperty, void* Container)
+int FLuaTArray::ConstructArray(lua_State* L, FArrayProperty* ArrayProperty, void* Value)
 {
 	if (!ArrayProperty->IsValidLowLevel())
 	{
@@ -18,38 +20,60 @@ int FLuaTArray::ConstructArray(lua_State* L, FArrayProperty* ArrayProperty, void
 		lua_pushnil(L);
 		return 1;
 	}
-	LOGF("Constructing a LuaTArray from %s", *ArrayProperty->GetName())
-	FLuaTArray** ReturnedInstance = static_cast<FLuaTArray**>(lua_newuserdata(L, sizeof(FLuaTArray*)));
-	*ReturnedInstance = new FLuaTArray(ArrayProperty, Container);
-	luaL_getmetatable(L, FLuaTArray::Name);
-	lua_setmetatable(L, -2);
+	LOGFT("Constructing a LuaTArray from %s", *ArrayProperty->GetName())
+	FLuaTArray* Instance = FTILua::LuaT_NewUserdata<FLuaTArray>(L, ArrayProperty, Value);
+	Instance->ReferenceHandle = FLuaState::Get(L)->AddReference(Instance->Owner);
 	return 1;
 }
 
 FLuaTArray* FLuaTArray::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaTArray**>(luaL_checkudata(L, Index, Name));
+	return static_cast<FLuaTArray*>(luaL_checkudata(L, Index, Name));
 }
 
-void FLuaTArray::AddReferencedObjects(FReferenceCollector& Collector)
+int FLuaTArray::Lua_ToTable(lua_State* L)
 {
-	Collector.AddReferencedObject(ArrayProperty);
+	FLuaTArray* Self = Get(L);
+	FTIPropertyMarshaller::ArrayToTable(L, Self->ArrayProperty, Self->Value, 1);
+	return 1;
+}
+
+int FLuaTArray::Lua_FromTable(lua_State* L)
+{
+	FLuaTArray* Self = Get(L);
+	FTIPropertyMarshaller::TableToArray(L, Self->ArrayProperty, Self->Value, 2);
+	return 0;
 }
 
 int FLuaTArray::Lua__index(lua_State* L)
 {
 	FLuaTArray* Self = Get(L);
+	if (lua_type(L, 2) == LUA_TSTRING)
+	{
+		lua_CFunction* Method = Methods.Find(lua_tostring(L, 2));
+		if (Method)
+		{
+			lua_pushcfunction(L, *Method);
+		}
+		else
+		{
+			lua_pushnil(L);
+		}
+		return 1;
+	}
 	int Index = luaL_checkinteger(L, 2) - 1;
-	LOGF("Indexing a LuaTArray with %d", Index)
-	FScriptArray* ArrayValue = Self->ArrayProperty->ContainerPtrToValuePtr<FScriptArray>(Self->Container);
+	LOGFT("Indexing a LuaTArray with %d", Index)
+	FScriptArray* ArrayValue = Self->Value;
 	if (!ArrayValue->IsValidIndex(Index))
 	{
 		LOGF("Index %d isn't valid, the array is %d long", Index + 1, ArrayValue->Num())
 		lua_pushnil(L);
 		return 1;
 	}
-	FTILua::PropertyToLua(L, Self->ArrayProperty->Inner,
+	Self->InnerConverter.ToLua(L, Self->ArrayProperty->Inner,
 	              static_cast<uint8*>(ArrayValue->GetData()) + Self->ArrayProperty->Inner->ElementSize * Index);
+	// Struct and array elements point into our value
+	FTILua::LuaT_KeepParentAlive(L, 1);
 	return 1;
 }
 
@@ -57,16 +81,15 @@ int FLuaTArray::Lua__newindex(lua_State* L)
 {
 	FLuaTArray* Self = Get(L);
 	int Index = luaL_checkinteger(L, 2) - 1;
-	LOGF("Newindexing a LuaTArray with %d", Index)
-	FScriptArray* ArrayValue = Self->ArrayProperty->ContainerPtrToValuePtr<FScriptArray>(Self->Container);
-	if (!ArrayValue->IsValidIndex(Index))
+	LOGFT("Newindexing a LuaTArray with %d", Index)
+	FScriptArrayHelper Array(Self->ArrayProperty, Self->Value);
+	if (!Array.IsValidIndex(Index))
 	{
-		int appendCount = (Index + 1) - ArrayValue->Num();
+		int appendCount = (Index + 1) - Array.Num();
 		LOGF("Creating %d values", appendCount)
-		ArrayValue->Add(appendCount, Self->ArrayProperty->Inner->ElementSize);
+		Array.AddValues(appendCount);
 	}
-	FTILua::LuaToProperty(L, Self->ArrayProperty->Inner,
-	              static_cast<uint8*>(ArrayValue->GetData()) + Self->ArrayProperty->Inner->ElementSize * Index, 3);
+	Self->InnerConverter.FromLua(L, Self->ArrayProperty->Inner, Array.GetRawPtr(Index), 3);
 	return 0;
 }
 
@@ -80,15 +103,39 @@ int FLuaTArray::Lua__tostring(lua_State* L)
 int FLuaTArray::Lua__len(lua_State* L)
 {
 	FLuaTArray* Self = Get(L);
-	FScriptArray* Value = Self->ArrayProperty->ContainerPtrToValuePtr<FScriptArray>(Self->Container);
-	lua_pushinteger(L, Value->Num());
+	lua_pushinteger(L, Self->Value->Num());
 	return 1;
 }
 
+int FLuaTArray::Lua__pairs(lua_State* L)
+{
+	Get(L);
+	lua_pushcfunction(L, PairsNext);
+	lua_pushvalue(L, 1);
+	lua_pushinteger(L, 0);
+	return 3;
+}
+
+int FLuaTArray::PairsNext(lua_State* L)
+{
+	FLuaTArray* Self = Get(L);
+	const lua_Integer Index = luaL_checkinteger(L, 2);
+	if (!Self->Value->IsValidIndex(static_cast<int32>(Index)))
+	{
+		return 0;
+	}
+	lua_pushinteger(L, Index + 1);
+	FScriptArrayHelper Array(Self->ArrayProperty, Self->Value);
+	Self->InnerConverter.ToLua(L, Self->ArrayProperty->Inner, Array.GetRawPtr(Index));
+	FTILua::LuaT_KeepParentAlive(L, 1);
+	return 2;
+}
+
 int FLuaTArray::Lua__gc(lua_State* L)
 {
 	FLuaTArray* Self = Get(L);
-	delete Self;
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	Self->~FLuaTArray();
 	return 0;
 }
 
@@ -1,35 +1,50 @@
 #pragma once
 
 #include "TweakIt/Lua/lib/lua.hpp"
+#include "TweakIt/Lua/PropertyMarshaller.h"
 
-struct FLuaTArray : FGCObject
+struct FLuaTArray
 {
-	FLuaTArray(FArrayProperty* Property, void* Container);
+	FLuaTArray(FArrayProperty* Property, void* Value);
 	
 	FArrayProperty* ArrayProperty;
 	// TODO: Handle possible collection/removal
-	void* Container;
+	FScriptArray* Value;
+	// The class or struct declaring the property, kept alive so the property is too
+	UObject* Owner;
+	int32 ReferenceHandle = INDEX_NONE;
+	FTIPropertyConverter InnerConverter;
 
-	static int ConstructArray(lua_State* L, FArrayProperty* ArrayProperty, void* Container);
+	static int ConstructArray(lua_State* L, FArrayProperty* ArrayProperty, void* Value);
 	static FLuaTArray* Get(lua_State* L, int Index = 1);
 
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	static int Lua_ToTable(lua_State* L);
+	static int Lua_FromTable(lua_State* L);
 
 	static int Lua__index(lua_State* L);
 	static int Lua__newindex(lua_State* L);
 	static int Lua__tostring(lua_State* L);
 	static int Lua__len(lua_State* L);
+	static int Lua__pairs(lua_State* L);
 	static int Lua__gc(lua_State* L);
 
 	static void RegisterMetadata(lua_State* L);
 	inline static const char* Name = "TArray";
 
 private:
+	static int PairsNext(lua_State* L);
+
+	inline static TMap<FString, lua_CFunction> Methods = {
+		{"ToTable", Lua_ToTable},
+		{"FromTable", Lua_FromTable},
+	};
+
 	inline static TArray<luaL_Reg> Metadata = {
 		{"__index", Lua__index},
 		{"__newindex", Lua__newindex},
 		{"__tostring", Lua__tostring},
 		{"__len", Lua__len},
+		{"__pairs", Lua__pairs},
 		{"__gc", Lua__gc}
 	};
 };
@@ -1,9 +1,13 @@
 #include "LuaUClass.h"
 #include "TweakIt/Lua/Lua.h"
 #include "TweakIt/Helpers/TiReflection.h"
+#include "TweakIt/Helpers/TIDefaultValuePropagator.h"
+#include "TweakIt/Helpers/TIPropertyPredicate.h"
+#include "Async/ParallelFor.h"
 #include <string>
 #include "LuaUObject.h"
 #include "TweakIt/Logging/FTILog.h"
+#include "TweakIt/Lua/LuaState.h"
 using namespace std;
 
 FLuaUClass::FLuaUClass(UClass* Class) : Class(Class)
@@ -19,22 +23,15 @@ int FLuaUClass::ConstructClass(lua_State* L, UClass* Class)
 		lua_pushnil(L);
 		return 1;
 	}
-	LOGF("Constructing a LuaUClass from %s", *Class->GetName())
-	FLuaUClass** ReturnedInstance = static_cast<FLuaUClass**>(lua_newuserdata(L, sizeof(FLuaUClass*)));
-	*ReturnedInstance = new FLuaUClass(Class);
-	luaL_getmetatable(L, FLuaUClass::Name);
-	lua_setmetatable(L, -2);
+	LOGFT("Constructing a LuaUClass from %s", *Class->GetName())
+	FLuaUClass* Instance = FTILua::LuaT_NewUserdata<FLuaUClass>(L, Class);
+	Instance->ReferenceHandle = FLuaState::Get(L)->AddReference(Instance->Class);
 	return 1;
 }
 
 FLuaUClass* FLuaUClass::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaUClass**>(luaL_checkudata(L, Index, Name));
-}
-
-void FLuaUClass::AddReferencedObjects(FReferenceCollector& Collector)
-{
-	Collector.AddReferencedObject(Class);
+	return static_cast<FLuaUClass*>(luaL_checkudata(L, Index, Name));
 }
 
 int FLuaUClass::Lua_GetDefaultValue(lua_State* L)
@@ -75,28 +72,92 @@ int FLuaUClass::Lua_ChangeDefaultValue(lua_State* L)
 	bool IsRecursive = static_cast<bool>(lua_toboolean(L, 4));
 	LOGF("Calling ChangeDefaultValue(%s, <value>, %hhd) on class %s", *PropertyName, IsRecursive,
 	     *Self->Class->GetName())
-	TArray<UClass*> Classes;
-	Classes.Add(Self->Class);
-	if (IsRecursive)
+	// Subclasses inherit the property, so it's looked up once. Their objects were always changed, recursive or not
+	FProperty* Property = FTIReflection::FindPropertyByName(Self->Class, *PropertyName);
+	if (!Property->IsValidLowLevel())
+	{
+		LOG("Couldn't find the property")
+		return 0;
+	}
+	FLuaState* State = FLuaState::Get(L);
+	if (State->TweakDepth > 0)
 	{
-		GetDerivedClasses(Self->Class, Classes);
+		State->Tweaks.AddChange(L, Self->Class, Property, 3);
+		return 0;
 	}
-	for (auto Class : Classes)
+	FTIDefaultValuePropagator Propagator;
+	Propagator.Journal = State->Journal.Get();
+	Propagator.AddChange(L, Self->Class, Property, 3);
+	Propagator.Propagate();
+	return 0;
+}
+
+namespace
+{
+	struct FDefaults
+	{
+		UClass* Class;
+		FTIDefaultValuePropagator* Propagator;
+	};
+}
+
+int FLuaUClass::Lua_SetDefaults(lua_State* L)
+{
+	FLuaUClass* Self = Get(L);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	LOGF("Setting the defaults of %s", *Self->Class->GetName())
+	FLuaState* State = FLuaState::Get(L);
+	if (State->TweakDepth > 0)
+	{
+		// Values added before an error are propagated with the rest of the tweaks
+		return AddDefaults(L, Self->Class, State->Tweaks) ? 0 : lua_error(L);
+	}
+	bool Added;
+	{
+		FTIDefaultValuePropagator Propagator;
+		Propagator.Journal = State->Journal.Get();
+		Added = AddDefaults(L, Self->Class, Propagator);
+		// Even on error, so the objects keep matching the defaults that were already changed
+		const FTIPropagationStats Stats = Propagator.Propagate();
+		if (Added)
+		{
+			FTILua::PropagationStatsToLua(L, Stats);
+		}
+	}
+	// Raised once the propagator is gone
+	return Added ? 1 : lua_error(L);
+}
+
+bool FLuaUClass::AddDefaults(lua_State* L, UClass* Class, FTIDefaultValuePropagator& Propagator)
+{
+	FDefaults Defaults = {Class, &Propagator};
+	lua_pushcfunction(L, AddDefaultsProtected);
+	lua_pushlightuserdata(L, &Defaults);
+	lua_pushvalue(L, 2);
+	return lua_pcall(L, 2, 0, 0) == LUA_OK;
+}
+
+int FLuaUClass::AddDefaultsProtected(lua_State* L)
+{
+	const FDefaults* Defaults = static_cast<FDefaults*>(lua_touserdata(L, 1));
+	lua_pushnil(L);
+	while (lua_next(L, 2))
 	{
-		LOG("Changing the default value of a class")
-		FProperty* Property = FTIReflection::FindPropertyByName(Class, *PropertyName);
-		if (!Property->IsValidLowLevel())
+		if (lua_type(L, -2) != LUA_TSTRING)
 		{
-			LOG("Couldn't find the property")
-			return 0;
+			return luaL_error(L, "SetDefaults expects property names as keys");
 		}
-		FTILua::LuaToProperty(L, Property, Class->GetDefaultObject(), 3);
-		LOG("Changed the class's CDO. Iterating over objects...")
-		for (FObjectIterator It = FObjectIterator(Class); It; ++It)
+		const char* PropertyName = lua_tostring(L, -2);
+		FProperty* Property = FTIReflection::FindPropertyByName(Defaults->Class, UTF8_TO_TCHAR(PropertyName));
+		if (Property->IsValidLowLevel())
 		{
-			FTILua::LuaToProperty(L, Property, *It, 3);
+			Defaults->Propagator->AddChange(L, Defaults->Class, Property, -1);
 		}
-		LOG("Finished iteration over objects")
+		else
+		{
+			LOGFL("%s has no property %s", Warning, *Defaults->Class->GetName(), UTF8_TO_TCHAR(PropertyName))
+		}
+		lua_pop(L, 1);
 	}
 	return 0;
 }
@@ -180,6 +241,65 @@ int FLuaUClass::Lua_GetObjects(lua_State* L)
 	return 1;
 }
 
+int FLuaUClass::Lua_Objects(lua_State* L)
+{
+	FLuaUClass* Self = Get(L);
+	FLuaObjectIterator::ConstructIterator(L, Self->Class);
+	FLuaObjectIterator* Iterator = FLuaObjectIterator::Get(L, -1);
+	if (!lua_isnoneornil(L, 2))
+	{
+		luaL_checktype(L, 2, LUA_TTABLE);
+		Iterator->ReadFilters(L, 2);
+	}
+	return 1;
+}
+
+int FLuaUClass::Lua_Query(lua_State* L)
+{
+	FLuaUClass* Self = Get(L);
+	const char* Path = luaL_checkstring(L, 2);
+	ETIComparison Comparison;
+	if (!FTIPropertyPredicate::ParseComparison(luaL_checkstring(L, 3), Comparison))
+	{
+		return luaL_argerror(L, 3, "expected ==, ~=, <, <=, > or >=");
+	}
+	TArray<FProperty*> Properties;
+	if (!FTIReflection::FindPropertyPath(Self->Class, UTF8_TO_TCHAR(Path), Properties))
+	{
+		return luaL_error(L, "%s has no property %s", TCHAR_TO_UTF8(*Self->Class->GetName()), Path);
+	}
+	// Raised with nothing left to free, Properties is empty once moved
+	const TUniquePtr<FTIPropertyPredicate> Predicate = FTIPropertyPredicate::Make(MoveTemp(Properties), Comparison, L, 4);
+	if (!Predicate)
+	{
+		return lua_error(L);
+	}
+	LOGFV("Querying the objects of %s where %s %s", *Self->Class->GetName(), UTF8_TO_TCHAR(Path), UTF8_TO_TCHAR(lua_tostring(L, 3)))
+
+	TArray<UObject*> Objects;
+	GetObjectsOfClass(Self->Class, Objects, true, RF_ClassDefaultObject, EInternalObjectFlags::PendingKill);
+	// Objects are only read, the game thread waits for the workers. Small sets aren't worth the task overhead
+	constexpr int32 MinParallelObjects = 1024;
+	TArray<bool> Matches;
+	Matches.SetNumZeroed(Objects.Num());
+	ParallelFor(Objects.Num(), [&](int32 i)
+	{
+		Matches[i] = Predicate->Matches(Objects[i]);
+	}, Objects.Num() < MinParallelObjects);
+
+	lua_newtable(L);
+	int Found = 0;
+	for (int32 i = 0; i < Objects.Num(); i++)
+	{
+		if (Matches[i])
+		{
+			FLuaUObject::ConstructObject(L, Objects[i]);
+			lua_seti(L, -2, ++Found);
+		}
+	}
+	return 1;
+}
+
 int FLuaUClass::Lua_DumpProperties(lua_State* L)
 {
 	FLuaUClass* Self = Get(L);
@@ -200,7 +320,7 @@ int FLuaUClass::Lua__index(lua_State* L)
 {
 	FLuaUClass* Self = Get(L);
 	const FString Index = luaL_checkstring(L, 2);
-	LOGF("Indexing a LuaUClass that holds %s with %s", *Self->Class->GetName(), *Index)
+	LOGFT("Indexing a LuaUClass that holds %s with %s", *Self->Class->GetName(), *Index)
 	if (lua_CFunction* Method = Methods.Find(Index))
 	{
 		lua_pushcfunction(L, *Method);
@@ -242,7 +362,8 @@ int FLuaUClass::Lua__tostring(lua_State* L)
 int FLuaUClass::Lua__gc(lua_State* L)
 {
 	FLuaUClass* Self = Get(L);
-	delete Self;
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	Self->~FLuaUClass();
 	return 0;
 }
 
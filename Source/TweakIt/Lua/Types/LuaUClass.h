@@ -3,22 +3,24 @@
 
 #include "TweakIt/Lua/Lua.h"
 
-struct FLuaUClass : FGCObject
+struct FLuaUClass
 {
 	FLuaUClass(UClass* Class);
 	UClass* Class;
+	int32 ReferenceHandle = INDEX_NONE;
 
 	static int ConstructClass(lua_State* L, UClass* Class);
 	static FLuaUClass* Get(lua_State* L, int Index = 1);
 
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
-
 	static int Lua_GetDefaultValue(lua_State* L);
 	static int Lua_ChangeDefaultValue(lua_State* L);
+	static int Lua_SetDefaults(lua_State* L);
 	static int Lua_AddDefaultComponent(lua_State* L);
 	static int Lua_RemoveDefaultComponent(lua_State* L);
 	static int Lua_GetChildClasses(lua_State* L);
 	static int Lua_GetObjects(lua_State* L);
+	static int Lua_Objects(lua_State* L);
+	static int Lua_Query(lua_State* L);
 	static int Lua_DumpProperties(lua_State* L);
 	static int Lua_MakeSubclass(lua_State* L);
 
@@ -32,6 +34,11 @@ struct FLuaUClass : FGCObject
 	inline static const char* Name = "UClass";
 
 private:
+	// Adds the values of the table at index 2 to the propagator in a protected call. Returns false with the error
+	// pushed, the values before it stay added
+	static bool AddDefaults(lua_State* L, UClass* Class, class FTIDefaultValuePropagator& Propagator);
+	static int AddDefaultsProtected(lua_State* L);
+
 	inline static TArray<luaL_Reg> Metadata = {
 		{"__index", Lua__index},
 		{"__newindex", Lua__newindex},
@@ -43,8 +50,11 @@ private:
 	inline static TMap<FString, lua_CFunction> Methods = {
 		{"GetDefaultValue", Lua_GetDefaultValue},
 		{"ChangeDefaultValue", Lua_ChangeDefaultValue},
+		{"SetDefaults", Lua_SetDefaults},
 		{"GetChildClasses", Lua_GetChildClasses},
 		{"GetObjects", Lua_GetObjects},
+		{"Objects", Lua_Objects},
+		{"Query", Lua_Query},
 		{"MakeSubclass", Lua_MakeSubclass},
 		{"AddDefaultComponent", Lua_AddDefaultComponent},
 		{"RemoveDefaultComponent", Lua_RemoveDefaultComponent},
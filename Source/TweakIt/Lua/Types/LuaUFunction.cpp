@@ -4,37 +4,32 @@
 #include "TweakIt/Helpers/TIUFunctionBinder.h"
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Lua/FTILuaFuncManager.h"
+#include "TweakIt/Lua/LuaState.h"
 
 FLuaUFunction::FLuaUFunction(UFunction* Function, UObject* Object) : Function(Function), Object(Object)
 {
 	
 }
 
-void FLuaUFunction::AddReferencedObjects(FReferenceCollector& Collector)
-{
-	Collector.AddReferencedObject(Object);
-	Collector.AddReferencedObject(Function);
-}
-
 int FLuaUFunction::Construct(lua_State* L, UFunction* Function, UObject* Object)
 {
-	LOG("Constructing a LuaUFunction")
+	LOGT("Constructing a LuaUFunction")
 	if (!Function->IsValidLowLevel())
 	{
 		LOG("Trying to construct a LuaUFunction from an invalid function")
 		lua_pushnil(L);
 		return 1;
 	}
-	FLuaUFunction** ReturnedInstance = static_cast<FLuaUFunction**>(lua_newuserdata(L, sizeof(FLuaUFunction*)));
-	*ReturnedInstance = new FLuaUFunction(Function, Object);
-	luaL_getmetatable(L, FLuaUFunction::Name);
-	lua_setmetatable(L, -2);
+	FLuaUFunction* Instance = FTILua::LuaT_NewUserdata<FLuaUFunction>(L, Function, Object);
+	FLuaState* State = FLuaState::Get(L);
+	Instance->FunctionHandle = State->AddReference(Instance->Function);
+	Instance->ObjectHandle = State->AddReference(Instance->Object);
 	return 1;
 }
 
 FLuaUFunction* FLuaUFunction::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaUFunction**>(luaL_checkudata(L, Index, Name));
+	return static_cast<FLuaUFunction*>(luaL_checkudata(L, Index, Name));
 }
 
 bool FLuaUFunction::Is(lua_State* L, int Index)
@@ -62,12 +57,7 @@ int FLuaUFunction::Lua_Bind(lua_State* L)
 {
 	FLuaUFunction* Self = Get(L);
 	FTILua::LuaT_ExpectLuaFunction(L, 2);
-	FString FunctionName = Self->Function->GetFullName();
-	LOG(FunctionName)
-	FTILuaFuncManager::DumpFunction(L, FunctionName, 2);
-	LOG(FTILuaFuncManager::GetSavedLuaFunc(FunctionName).IsOk())
-	FNativeFuncPtr Func = FTILuaFuncManager::SavedLuaFuncToNativeFunc(L, FunctionName);
-	Self->Function->SetNativeFunc(Func);
+	FTILuaFuncManager::BindLuaFunction(L, Self->Function, 2);
 	return 0;
 }
 
@@ -75,7 +65,7 @@ int FLuaUFunction::Lua__index(lua_State* L)
 {
 	FLuaUFunction* Self = Get(L);
 	FString Index = luaL_checkstring(L, 2);
-	LOGF("Indexing a LuaUFunction with %s", *Index)
+	LOGFT("Indexing a LuaUFunction with %s", *Index)
 	if (lua_CFunction* Method = Methods.Find(Index))
 	{
 		lua_pushcfunction(L, *Method);
@@ -106,7 +96,10 @@ int FLuaUFunction::Lua__tostring(lua_State* L)
 int FLuaUFunction::Lua__gc(lua_State* L)
 {
 	FLuaUFunction* Self = Get(L);
-	delete Self;
+	FLuaState* State = FLuaState::Get(L);
+	State->RemoveReference(Self->FunctionHandle);
+	State->RemoveReference(Self->ObjectHandle);
+	Self->~FLuaUFunction();
 	return 0;
 }
 
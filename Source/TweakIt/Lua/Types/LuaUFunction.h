@@ -2,11 +2,9 @@
 
 #include "TweakIt/Lua/Lua.h"
 
-struct FLuaUFunction : FGCObject
+struct FLuaUFunction
 {
 	explicit FLuaUFunction(UFunction* Function, UObject* Object);
-	
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
 
 	static int Construct(lua_State* L, UFunction* Function, UObject* Object);
 	static FLuaUFunction* Get(lua_State* L, int Index = 1);
@@ -25,6 +23,8 @@ struct FLuaUFunction : FGCObject
 
 	UFunction* Function;
 	UObject* Object;
+	int32 FunctionHandle = INDEX_NONE;
+	int32 ObjectHandle = INDEX_NONE;
 	
 private:
 	inline static TArray<luaL_Reg> Metadata = {
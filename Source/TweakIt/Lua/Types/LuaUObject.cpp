@@ -5,6 +5,7 @@
 
 #include "TweakIt/Logging/FTILog.h"
 #include "TweakIt/Helpers/TIReflection.h"
+#include "TweakIt/Lua/LuaState.h"
 using namespace std;
 
 FLuaUObject::FLuaUObject(UObject* Object) : Object(Object)
@@ -14,28 +15,36 @@ FLuaUObject::FLuaUObject(UObject* Object) : Object(Object)
 
 int FLuaUObject::ConstructObject(lua_State* L, UObject* Object)
 {
-	LOG("Constructing a LuaUObject")
+	LOGT("Constructing a LuaUObject")
 	if (!Object->IsValidLowLevel())
 	{
 		LOGL("Trying to construct a LuaUObject from an invalid object", Warning)
 		lua_pushnil(L);
 		return 1;
 	}
-	FLuaUObject** ReturnedInstance = static_cast<FLuaUObject**>(lua_newuserdata(L, sizeof(FLuaUObject*)));
-	*ReturnedInstance = new FLuaUObject(Object);
-	luaL_getmetatable(L, FLuaUObject::Name);
-	lua_setmetatable(L, -2);
+	FLuaState* State = FLuaState::Get(L);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, State->ObjectCache);
+	if (lua_rawgetp(L, -1, Object) == LUA_TUSERDATA)
+	{
+		// The GC clears the pointer of destroyed objects, and the address may have been reused since
+		if (static_cast<FLuaUObject*>(lua_touserdata(L, -1))->Object == Object)
+		{
+			lua_remove(L, -2);
+			return 1;
+		}
+	}
+	lua_pop(L, 1);
+	FLuaUObject* Instance = FTILua::LuaT_NewUserdata<FLuaUObject>(L, Object);
+	Instance->ReferenceHandle = State->AddReference(Instance->Object);
+	lua_pushvalue(L, -1);
+	lua_rawsetp(L, -3, Object);
+	lua_remove(L, -2);
 	return 1;
 }
 
 FLuaUObject* FLuaUObject::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaUObject**>(luaL_checkudata(L, Index, Name));
-}
-
-void FLuaUObject::AddReferencedObjects(FReferenceCollector& Collector)
-{
-	Collector.AddReferencedObject(Object);
+	return static_cast<FLuaUObject*>(luaL_checkudata(L, Index, Name));
 }
 
 int FLuaUObject::Lua_DumpProperties(lua_State* L)
@@ -71,7 +80,7 @@ int FLuaUObject::Lua__index(lua_State* L)
 {
 	FLuaUObject* Self = Get(L);
 	FString Index = luaL_checkstring(L, 2);
-	LOGF("Indexing a LuaUObject with %s", *Index)
+	LOGFT("Indexing a LuaUObject with %s", *Index)
 	if (lua_CFunction* Method = Methods.Find(Index))
 	{
 		lua_pushcfunction(L, *Method);
@@ -89,7 +98,7 @@ int FLuaUObject::Lua__index(lua_State* L)
 		FTILua::UFunctionToLua(L, Function, Self->Object);
 		return 1;
 	}
-	LOG("Found property")
+	LOGT("Found property")
 	FTILua::PropertyToLua(L, Property, Self->Object);
 	return 1;
 }
@@ -99,14 +108,18 @@ int FLuaUObject::Lua__newindex(lua_State* L)
 	{
 		FLuaUObject* Self = Get(L);
 		FString PropertyName = luaL_checkstring(L, 2);
-		LOGF("Newindexing a LuaUObject with %s", *PropertyName)
+		LOGFT("Newindexing a LuaUObject with %s", *PropertyName)
 		FProperty* Property = FTIReflection::FindPropertyByName(Self->Object->GetClass(), *PropertyName);
 		if (!Property->IsValidLowLevel())
 		{
 			LOGF("No property '%s' found", *PropertyName)
 			return 0;
 		}
-		LOG("Found property")
+		LOGT("Found property")
+		if (FTIChangeJournal* Journal = FLuaState::Get(L)->Journal.Get())
+		{
+			Journal->Record(Self->Object, Property);
+		}
 		FTILua::LuaToProperty(L, Property, Self->Object, 3);
 		return 0;
 	}
@@ -119,10 +132,19 @@ int FLuaUObject::Lua__tostring(lua_State* L)
 	return 1;
 }
 
+int FLuaUObject::Lua__eq(lua_State* L)
+{
+	FLuaUObject* Self = Get(L);
+	FLuaUObject* Other = static_cast<FLuaUObject*>(luaL_testudata(L, 2, Name));
+	lua_pushboolean(L, Other && Self->Object == Other->Object);
+	return 1;
+}
+
 int FLuaUObject::Lua__gc(lua_State* L)
 {
 	FLuaUObject* Self = Get(L);
-	delete Self;
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	Self->~FLuaUObject();
 	return 0;
 }
 
@@ -3,23 +3,24 @@
 
 #include "TweakIt/Lua/Lua.h"
 
-struct FLuaUObject : FGCObject
+struct FLuaUObject
 {
 	explicit FLuaUObject(UObject* Object);
 
 	UObject* Object;
+	int32 ReferenceHandle = INDEX_NONE;
 
+	// The same object always gets the same wrapper while the wrapper is alive, so it can be compared and used as a key
 	static int ConstructObject(lua_State* L, UObject* Object);
 	static FLuaUObject* Get(lua_State* L, int Index = 1);
 
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
-
 	static int Lua_DumpProperties(lua_State* L);
 	static int Lua_GetClass(lua_State* L);
 
 	static int Lua__index(lua_State* L);
 	static int Lua__newindex(lua_State* L);
 	static int Lua__tostring(lua_State* L);
+	static int Lua__eq(lua_State* L);
 	static int Lua__gc(lua_State* L);
 
 	static void RegisterMetadata(lua_State* L);
@@ -35,6 +36,7 @@ private:
 		{"__index", Lua__index},
 		{"__newindex", Lua__newindex},
 		{"__tostring", Lua__tostring},
+		{"__eq", Lua__eq},
 		{"__gc", Lua__gc},
 	};
 	bool MadeRoot = false;
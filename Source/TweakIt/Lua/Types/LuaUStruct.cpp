@@ -2,9 +2,10 @@
 #include "TweakIt/Helpers/TiReflection.h"
 #include <string>
 #include "TweakIt/Logging/FTILog.h"
+#include "TweakIt/Lua/LuaState.h"
 using namespace std;
 
-FLuaUStruct::FLuaUStruct(UStruct* Struct, void* Values) : Struct(Struct), Values(Values)
+FLuaUStruct::FLuaUStruct(UStruct* Struct, void* Values, bool Owning) : Struct(Struct), Values(Values), Owning(Owning)
 {
 	
 }
@@ -17,29 +18,22 @@ int FLuaUStruct::ConstructStruct(lua_State* L, UStruct* Struct, void* Values, bo
 		lua_pushnil(L);
 		return 1;
 	}
-	LOGF("Constructing a LuaUStruct from %s", *Struct->GetName())
-	FLuaUStruct** ReturnedInstance = static_cast<FLuaUStruct**>(lua_newuserdata(L, sizeof(FLuaUStruct*)));
-	*ReturnedInstance = new FLuaUStruct(Struct, Values);
-	luaL_getmetatable(L, Name);
-	lua_setmetatable(L, -2);
+	LOGFT("Constructing a LuaUStruct from %s", *Struct->GetName())
+	FLuaUStruct* Instance = FTILua::LuaT_NewUserdata<FLuaUStruct>(L, Struct, Values, Owning);
+	Instance->ReferenceHandle = FLuaState::Get(L)->AddReference(Instance->Struct);
 	return 1;
 }
 
 FLuaUStruct* FLuaUStruct::Get(lua_State* L, int Index)
 {
-	return *static_cast<FLuaUStruct**>(luaL_checkudata(L, Index, Name));
-}
-
-void FLuaUStruct::AddReferencedObjects(FReferenceCollector& Collector)
-{
-	Collector.AddReferencedObject(Struct);
+	return static_cast<FLuaUStruct*>(luaL_checkudata(L, Index, Name));
 }
 
 int FLuaUStruct::Lua_Copy(lua_State* L)
 {
 	FLuaUStruct* Self = Get(L);
 	void* Copy = FTIReflection::CopyStruct(Self->Struct, Self->Values);
-	return ConstructStruct(L, Self->Struct, Copy);
+	return ConstructStruct(L, Self->Struct, Copy, true);
 }
 
 int FLuaUStruct::Lua_MakeStructInstance(lua_State* L)
@@ -51,7 +45,7 @@ int FLuaUStruct::Lua__index(lua_State* L)
 {
 	FLuaUStruct* Self = Get(L);
 	FString Index = luaL_checkstring(L, 2);
-	LOGF("Indexing a LuaUStruct with %s", *Index)
+	LOGFT("Indexing a LuaUStruct with %s", *Index)
 	if (lua_CFunction* Method = Methods.Find(Index))
 	{
 		lua_pushcfunction(L, *Method);
@@ -65,6 +59,8 @@ int FLuaUStruct::Lua__index(lua_State* L)
 		return 1;
 	}
 	FTILua::PropertyToLua(L, NestedProperty, Self->Values);
+	// Nested structs and arrays point into our values, owned by us or by whatever we point into
+	FTILua::LuaT_KeepParentAlive(L, 1);
 	return 1;
 }
 
@@ -72,7 +68,7 @@ int FLuaUStruct::Lua__newindex(lua_State* L)
 {
 	FLuaUStruct* Self = Get(L);
 	FString Index = luaL_checkstring(L, 2);
-	LOGF("Newindexing a LuaUStruct with %s", *Index)
+	LOGFT("Newindexing a LuaUStruct with %s", *Index)
 	FProperty* NestedProperty = FTIReflection::FindPropertyByName(Self->Struct, *Index);
 	if (!NestedProperty->IsValidLowLevel())
 	{
@@ -94,7 +90,13 @@ int FLuaUStruct::Lua__tostring(lua_State* L)
 int FLuaUStruct::Lua__gc(lua_State* L)
 {
 	FLuaUStruct* Self = Get(L);
-	delete Self;
+	if (Self->Owning)
+	{
+		Self->Struct->DestroyStruct(Self->Values);
+		FMemory::Free(Self->Values);
+	}
+	FLuaState::Get(L)->RemoveReference(Self->ReferenceHandle);
+	Self->~FLuaUStruct();
 	return 0;
 }
 
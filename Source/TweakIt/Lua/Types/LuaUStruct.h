@@ -3,19 +3,20 @@
 
 #include "TweakIt/Lua/Lua.h"
 
-struct FLuaUStruct : FGCObject
+struct FLuaUStruct
 {
-	FLuaUStruct(UStruct* Struct, void* Values);
+	FLuaUStruct(UStruct* Struct, void* Values, bool Owning = false);
 	
 	UStruct* Struct;
 	// TODO: Handle possible collection/removal
 	void* Values;
+	// Values was allocated for this instance and is freed with it
+	bool Owning;
+	int32 ReferenceHandle = INDEX_NONE;
 	
 	static int ConstructStruct(lua_State* L, UStruct* Struct, void* Values, bool Owning = false);
 	static FLuaUStruct* Get(lua_State* L, int Index = 1);
 
-	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
-
 	static int Lua_Copy(lua_State* L);
 	static int Lua_MakeStructInstance(lua_State* L);
 
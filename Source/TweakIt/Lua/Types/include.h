@@ -5,4 +5,5 @@
 #include "LuaUObject.h"
 #include "LuaUStruct.h"
 #include "LuaFDelegate.h"
-#include "LuaUFunction.h"
\ No newline at end of file
+#include "LuaUFunction.h"
+#include "LuaObjectIterator.h"
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "UFunctionCallPlan.h"
+#include "TweakIt/Helpers/TIReflection.h"
+#include "TweakIt/Logging/FTILog.h"
+#include "Types/LuaUStruct.h"
+
+namespace
+{
+	struct FConversion
+	{
+		const FTICallPlan* Plan;
+		uint8* Params;
+		int StartIndex;
+	};
+}
+
+TMap<UFunction*, TSharedRef<FTICallPlan>> FTICallPlan::Plans = {};
+FDelegateHandle FTICallPlan::PostGarbageCollectHandle;
+
+FTICallPlan::FTICallPlan(UFunction* Function) : Function(Function), ParmsSize(Function->ParmsSize)
+{
+	for (FProperty* Prop = Function->PropertyLink; Prop; Prop = Prop->PropertyLinkNext)
+	{
+		if (!Prop->HasAnyPropertyFlags(CPF_Parm))
+		{
+			continue;
+		}
+		FTICallSlot Slot = {Prop, Prop->GetOffset_ForUFunction(), FTIPropertyMarshaller::GetConverter(Prop)};
+		if (!Prop->HasAnyPropertyFlags(CPF_ZeroConstructor))
+		{
+			NeedConstruction.Add(Prop);
+		}
+		if (!Prop->HasAnyPropertyFlags(CPF_IsPlainOldData | CPF_NoDestructor))
+		{
+			NeedDestruction.Add(Prop);
+		}
+		if (Prop->HasAnyPropertyFlags(CPF_ReturnParm))
+		{
+			Return = Slot;
+			continue;
+		}
+		// Pure out parameters have no value to pass in, reference parameters are both
+		if (!Prop->HasAnyPropertyFlags(CPF_OutParm) || Prop->HasAnyPropertyFlags(CPF_ReferenceParm))
+		{
+			Inputs.Add(Slot);
+		}
+		if (Prop->HasAnyPropertyFlags(CPF_OutParm) && !Prop->HasAnyPropertyFlags(CPF_ConstParm))
+		{
+			Outputs.Add(Slot);
+		}
+	}
+}
+
+TSharedRef<FTICallPlan> FTICallPlan::Get(UFunction* Function)
+{
+	if (!PostGarbageCollectHandle.IsValid())
+	{
+		PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&PurgeStalePlans);
+	}
+	// Returned by reference count, a hook called during Call can add plans and move the map around
+	TSharedRef<FTICallPlan>* Plan = Plans.Find(Function);
+	if (Plan && (*Plan)->Function.Get() == Function && (*Plan)->ParmsSize == Function->ParmsSize)
+	{
+		return *Plan;
+	}
+	LOGFV("Building the call plan of %s", *Function->GetFullName())
+	return Plans.Add(Function, MakeShareable(new FTICallPlan(Function)));
+}
+
+int FTICallPlan::Call(lua_State* L, UObject* Object, int StartIndex) const
+{
+	UFunction* Func = Function.Get();
+	check(Func)
+	check(Object->IsValidLowLevel())
+	uint8* Params;
+	if (ParmsSize <= MaxStackParmsSize)
+	{
+		Params = static_cast<uint8*>(FMemory_Alloca(ParmsSize));
+	}
+	else
+	{
+		// Lua owns the block, so it doesn't leak if a conversion errors out. Aligned by hand, like FMemory_Alloca
+		void* Block = lua_newuserdatauv(L, ParmsSize + 15, 0);
+		Params = reinterpret_cast<uint8*>((reinterpret_cast<PTRINT>(Block) + 15) & ~15);
+	}
+	FMemory::Memzero(Params, ParmsSize);
+	for (FProperty* Prop : NeedConstruction)
+	{
+		Prop->InitializeValue_InContainer(Params);
+	}
+	if (NeedDestruction.Num() == 0)
+	{
+		// Nothing to clean up if a conversion errors out
+		ConvertInputs(L, Params, StartIndex);
+	}
+	else
+	{
+		// Converted protected, so what the parameters own is destroyed before the error goes on
+		const int FirstInput = FMath::Max(StartIndex, 2);
+		FConversion Conversion = {this, Params, FirstInput};
+		luaL_checkstack(L, FirstInput + Inputs.Num(), nullptr);
+		const int Top = lua_gettop(L);
+		lua_pushcfunction(L, ConvertInputsProtected);
+		lua_pushlightuserdata(L, &Conversion);
+		// The values keep their indices, so argument errors still name the right argument
+		for (int i = 2; i < FirstInput; i++)
+		{
+			lua_pushnil(L);
+		}
+		for (int i = 0; i < Inputs.Num(); i++)
+		{
+			lua_pushvalue(L, StartIndex + i);
+		}
+		if (lua_pcall(L, lua_gettop(L) - Top - 1, 0, 0) != LUA_OK)
+		{
+			for (FProperty* Prop : NeedDestruction)
+			{
+				Prop->DestroyValue_InContainer(Params);
+			}
+			lua_error(L);
+		}
+	}
+	Object->ProcessEvent(Func, Params);
+	int Results = 0;
+	if (Return)
+	{
+		PushResult(L, Return->Property, Params + Return->Offset);
+		Results++;
+	}
+	for (const FTICallSlot& Slot : Outputs)
+	{
+		PushResult(L, Slot.Property, Params + Slot.Offset);
+		Results++;
+	}
+	for (FProperty* Prop : NeedDestruction)
+	{
+		Prop->DestroyValue_InContainer(Params);
+	}
+	return Results;
+}
+
+void FTICallPlan::ConvertInputs(lua_State* L, uint8* Params, int StartIndex) const
+{
+	for (int i = 0; i < Inputs.Num(); i++)
+	{
+		const FTICallSlot& Slot = Inputs[i];
+		Slot.Converter.FromLua(L, Slot.Property, Params + Slot.Offset, StartIndex + i);
+	}
+}
+
+int FTICallPlan::ConvertInputsProtected(lua_State* L)
+{
+	const FConversion* Conversion = static_cast<FConversion*>(lua_touserdata(L, 1));
+	Conversion->Plan->ConvertInputs(L, Conversion->Params, Conversion->StartIndex);
+	return 0;
+}
+
+void FTICallPlan::PushResult(lua_State* L, FProperty* Property, void* Value)
+{
+	// The parameter block is gone once the call returns, so nothing pushed can point into it
+	if (FStructProperty* StructProp = CastField<FStructProperty>(Property))
+	{
+		FLuaUStruct::ConstructStruct(L, StructProp->Struct, FTIReflection::CopyStruct(StructProp->Struct, Value), true);
+		return;
+	}
+	if (FArrayProperty* ArrayProp = CastField<FArrayProperty>(Property))
+	{
+		FScriptArrayHelper Helper(ArrayProp, Value);
+		lua_createtable(L, Helper.Num(), 0);
+		for (int i = 0; i < Helper.Num(); i++)
+		{
+			PushResult(L, ArrayProp->Inner, Helper.GetRawPtr(i));
+			lua_seti(L, -2, i + 1);
+		}
+		return;
+	}
+	FTIPropertyMarshaller::ToLua(L, Property, Value);
+}
+
+void FTICallPlan::PurgeStalePlans()
+{
+	for (auto It = Plans.CreateIterator(); It; ++It)
+	{
+		if (!It.Value()->Function.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "PropertyMarshaller.h"
+
+struct FTICallSlot
+{
+	FProperty* Property;
+	int32 Offset;
+	FTIPropertyConverter Converter;
+};
+
+// Everything CallUFunction needs to know about a UFunction's parameters, worked out once per function
+struct FTICallPlan
+{
+	TWeakObjectPtr<UFunction> Function;
+	int32 ParmsSize = 0;
+
+	// Parameters taken from Lua, in declaration order. Includes reference parameters
+	TArray<FTICallSlot> Inputs;
+	// Out and non-const reference parameters, returned to Lua after the return value
+	TArray<FTICallSlot> Outputs;
+	TOptional<FTICallSlot> Return;
+
+	// Parameters that can't just be zeroed, and parameters that own memory
+	TArray<FProperty*> NeedConstruction;
+	TArray<FProperty*> NeedDestruction;
+
+	static TSharedRef<FTICallPlan> Get(UFunction* Function);
+
+	// Calls the function with the Lua values starting at StartIndex and pushes the results. Returns the number of results
+	int Call(lua_State* L, UObject* Object, int StartIndex) const;
+
+private:
+	explicit FTICallPlan(UFunction* Function);
+
+	void ConvertInputs(lua_State* L, uint8* Params, int StartIndex) const;
+	static int ConvertInputsProtected(lua_State* L);
+	static void PushResult(lua_State* L, FProperty* Property, void* Value);
+	static void PurgeStalePlans();
+
+	// Parameter blocks bigger than this go on the Lua heap instead of the C stack
+	static constexpr int32 MaxStackParmsSize = 512;
+
+	static TMap<UFunction*, TSharedRef<FTICallPlan>> Plans;
+	static FDelegateHandle PostGarbageCollectHandle;
+};
@@ -1,12 +1,15 @@
 ﻿#include "TIGameWorldModule.h"
 
 #include "TweakIt/Commands/TIRunAllScriptsCommand.h"
+#include "TweakIt/Commands/TIRevertScriptCommand.h"
 #include "TweakIt/Commands/TIRunScriptCommand.h"
+#include "TweakIt/Commands/TIWatchScriptsCommand.h"
 
 UTIGameWorldModule::UTIGameWorldModule()
 {
 #if !WITH_EDITOR
 	bRootModule = true;
-	mChatCommands = {ATIRunScriptCommand::StaticClass(), ATIRunAllScriptsCommand::StaticClass()};
+	mChatCommands = {ATIRunScriptCommand::StaticClass(), ATIRunAllScriptsCommand::StaticClass(),
+		ATIRevertScriptCommand::StaticClass(), ATIWatchScriptsCommand::StaticClass()};
 #endif
 }
@@ -3,13 +3,20 @@
 #include "AssetRegistryModule.h"
 #include "FactoryGame/Public/Equipment/FGBuildGunDismantle.h"
 #include "Logging/FTILog.h"
+#include "Logging/FTILogWriter.h"
 #include "Patching/NativeHookManager.h"
 
 void FTweakItModule::StartupModule()
 {
+	FTILog::InitVerbosityFromCommandLine();
 	LOG("TweakIt 0.6.0 starting")
 	Orchestrator = new FTIScriptOrchestrator();
 	Orchestrator->StartAllScripts();
 }
 
+void FTweakItModule::ShutdownModule()
+{
+	FTILogWriter::Get().Shutdown();
+}
+
 IMPLEMENT_GAME_MODULE(FTweakItModule, TweakIt);
@@ -8,6 +8,7 @@ class FTweakItModule : public FDefaultGameModuleImpl
 {
 public:
 	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
 
 	virtual bool IsGameModule() const override { return true; }
 
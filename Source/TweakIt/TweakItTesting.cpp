@@ -2,6 +2,8 @@
 
 #include "Configuration/ConfigManager.h"
 #include "Logging/FTILog.h"
+#include "Lua/LuaState.h"
+#include "Lua/PropertyMarshaller.h"
 
 using namespace std;
 
@@ -36,3 +38,494 @@ void UTweakItTesting::InvalidTestingDelegate(FText ParmString, int ParmInt)
 {
 	LOG("UTweakItTesting::InvalidTestingDelegate called")
 }
+
+namespace
+{
+	double NanosecondsPerOp(double Start, int Iterations)
+	{
+		return (FPlatformTime::Seconds() - Start) * 1e9 / FMath::Max(Iterations, 1);
+	}
+
+	// The conversions before the converter table, a chain of CastField checks on every call. Types past the strings
+	// are still checked in the old order, then converted like the table does
+	bool IsLateChainedType(FProperty* Property)
+	{
+		return CastField<FClassProperty>(Property) || CastField<FEnumProperty>(Property) ||
+			CastField<FStructProperty>(Property) || CastField<FObjectProperty>(Property) ||
+			CastField<FArrayProperty>(Property) || CastField<FDelegateProperty>(Property) ||
+			CastField<FInterfaceProperty>(Property) || CastField<FFieldPathProperty>(Property);
+	}
+
+	void ChainedToLua(lua_State* L, FProperty* Property, void* Value)
+	{
+		if (FBoolProperty* BoolProp = CastField<FBoolProperty>(Property))
+		{
+			lua_pushboolean(L, BoolProp->GetPropertyValue(Value));
+		}
+		else if (FInt8Property* Int8Prop = CastField<FInt8Property>(Property))
+		{
+			lua_pushinteger(L, Int8Prop->GetPropertyValue(Value));
+		}
+		else if (FInt16Property* Int16Prop = CastField<FInt16Property>(Property))
+		{
+			lua_pushinteger(L, Int16Prop->GetPropertyValue(Value));
+		}
+		else if (FIntProperty* IntProp = CastField<FIntProperty>(Property))
+		{
+			lua_pushinteger(L, IntProp->GetPropertyValue(Value));
+		}
+		else if (FInt64Property* Int64Prop = CastField<FInt64Property>(Property))
+		{
+			lua_pushinteger(L, Int64Prop->GetPropertyValue(Value));
+		}
+		else if (FUInt16Property* UInt16Prop = CastField<FUInt16Property>(Property))
+		{
+			lua_pushinteger(L, UInt16Prop->GetPropertyValue(Value));
+		}
+		else if (FUInt32Property* UInt32Prop = CastField<FUInt32Property>(Property))
+		{
+			lua_pushinteger(L, UInt32Prop->GetPropertyValue(Value));
+		}
+		else if (FUInt64Property* UInt64Prop = CastField<FUInt64Property>(Property))
+		{
+			lua_pushinteger(L, UInt64Prop->GetPropertyValue(Value));
+		}
+		else if (FFloatProperty* FloatProp = CastField<FFloatProperty>(Property))
+		{
+			lua_pushnumber(L, FloatProp->GetPropertyValue(Value));
+		}
+		else if (FDoubleProperty* DoubleProp = CastField<FDoubleProperty>(Property))
+		{
+			lua_pushnumber(L, DoubleProp->GetPropertyValue(Value));
+		}
+		else if (CastField<FStrProperty>(Property))
+		{
+			lua_pushstring(L, TCHAR_TO_UTF8(**static_cast<FString*>(Value)));
+		}
+		else if (CastField<FNameProperty>(Property))
+		{
+			lua_pushstring(L, TCHAR_TO_UTF8(*static_cast<FName*>(Value)->ToString()));
+		}
+		else if (CastField<FTextProperty>(Property))
+		{
+			lua_pushstring(L, TCHAR_TO_UTF8(*static_cast<FText*>(Value)->ToString()));
+		}
+		else if (IsLateChainedType(Property))
+		{
+			FTIPropertyMarshaller::ToLua(L, Property, Value);
+		}
+		else
+		{
+			luaL_error(L, "Property type %s is unsupported", TCHAR_TO_UTF8(*Property->GetCPPType()));
+		}
+	}
+
+	void ChainedFromLua(lua_State* L, FProperty* Property, void* Value, int Index)
+	{
+		if (FBoolProperty* BoolProp = CastField<FBoolProperty>(Property))
+		{
+			BoolProp->SetPropertyValue(Value, FTILua::LuaT_CheckBoolean(L, Index));
+		}
+		else if (FInt8Property* Int8Prop = CastField<FInt8Property>(Property))
+		{
+			Int8Prop->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FInt16Property* Int16Prop = CastField<FInt16Property>(Property))
+		{
+			Int16Prop->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FIntProperty* IntProp = CastField<FIntProperty>(Property))
+		{
+			IntProp->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FInt64Property* Int64Prop = CastField<FInt64Property>(Property))
+		{
+			Int64Prop->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FUInt16Property* UInt16Prop = CastField<FUInt16Property>(Property))
+		{
+			UInt16Prop->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FUInt32Property* UInt32Prop = CastField<FUInt32Property>(Property))
+		{
+			UInt32Prop->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FUInt64Property* UInt64Prop = CastField<FUInt64Property>(Property))
+		{
+			UInt64Prop->SetPropertyValue(Value, luaL_checkinteger(L, Index));
+		}
+		else if (FFloatProperty* FloatProp = CastField<FFloatProperty>(Property))
+		{
+			FloatProp->SetPropertyValue(Value, luaL_checknumber(L, Index));
+		}
+		else if (FDoubleProperty* DoubleProp = CastField<FDoubleProperty>(Property))
+		{
+			DoubleProp->SetPropertyValue(Value, luaL_checknumber(L, Index));
+		}
+		else if (CastField<FStrProperty>(Property))
+		{
+			*static_cast<FString*>(Value) = UTF8_TO_TCHAR(luaL_checkstring(L, Index));
+		}
+		else if (CastField<FNameProperty>(Property))
+		{
+			*static_cast<FName*>(Value) = FName(luaL_checkstring(L, Index));
+		}
+		else if (CastField<FTextProperty>(Property))
+		{
+			*static_cast<FText*>(Value) = FText::FromString(luaL_checkstring(L, Index));
+		}
+		else if (IsLateChainedType(Property))
+		{
+			FTIPropertyMarshaller::FromLua(L, Property, Value, Index);
+		}
+		else
+		{
+			luaL_error(L, "Property type %s is unsupported", TCHAR_TO_UTF8(*Property->GetCPPType()));
+		}
+	}
+
+	// Runs inside lua_pcall so a failing conversion can't unwind past the benchmark
+	int RunMarshallingBenchmark(lua_State* L)
+	{
+		const int Iterations = luaL_checkinteger(L, 1);
+		UTweakItTesting* Testing = UTweakItTesting::Get();
+		for (FProperty* Property = UTweakItTesting::StaticClass()->PropertyLink; Property; Property = Property->PropertyLinkNext)
+		{
+			if (Property->GetOwnerClass() != UTweakItTesting::StaticClass())
+			{
+				continue;
+			}
+			void* Value = Property->ContainerPtrToValuePtr<void>(Testing);
+			FTIPropertyConverter Converter = FTIPropertyMarshaller::GetConverter(Property);
+
+			double Start = FPlatformTime::Seconds();
+			for (int i = 0; i < Iterations; ++i)
+			{
+				FTILua::PropertyToLua(L, Property, Testing);
+				lua_pop(L, 1);
+			}
+			const double EntryRead = NanosecondsPerOp(Start, Iterations);
+			Start = FPlatformTime::Seconds();
+			for (int i = 0; i < Iterations; ++i)
+			{
+				Converter.ToLua(L, Property, Value);
+				lua_pop(L, 1);
+			}
+			const double DirectRead = NanosecondsPerOp(Start, Iterations);
+			Start = FPlatformTime::Seconds();
+			for (int i = 0; i < Iterations; ++i)
+			{
+				ChainedToLua(L, Property, Value);
+				lua_pop(L, 1);
+			}
+			const double ChainedRead = NanosecondsPerOp(Start, Iterations);
+
+			// Arrays can only be assigned from tables and delegates can't be assigned at all
+			double EntryWrite = 0;
+			double DirectWrite = 0;
+			double ChainedWrite = 0;
+			if (!CastField<FArrayProperty>(Property) && !CastField<FDelegateProperty>(Property))
+			{
+				Converter.ToLua(L, Property, Value);
+				Start = FPlatformTime::Seconds();
+				for (int i = 0; i < Iterations; ++i)
+				{
+					FTILua::LuaToProperty(L, Property, Testing, -1);
+				}
+				EntryWrite = NanosecondsPerOp(Start, Iterations);
+				Start = FPlatformTime::Seconds();
+				for (int i = 0; i < Iterations; ++i)
+				{
+					Converter.FromLua(L, Property, Value, lua_gettop(L));
+				}
+				DirectWrite = NanosecondsPerOp(Start, Iterations);
+				Start = FPlatformTime::Seconds();
+				for (int i = 0; i < Iterations; ++i)
+				{
+					ChainedFromLua(L, Property, Value, lua_gettop(L));
+				}
+				ChainedWrite = NanosecondsPerOp(Start, Iterations);
+				lua_pop(L, 1);
+			}
+			LOGF("%s: read %.1f ns/op (%.1f dispatched, %.1f before), write %.1f ns/op (%.1f dispatched, %.1f before)",
+			     *Property->GetName(), EntryRead, DirectRead, ChainedRead, EntryWrite, DirectWrite, ChainedWrite)
+		}
+		return 0;
+	}
+
+	// Counts the engine allocations made by the game thread while enabled, passes everything through.
+	// Installed once and never removed: other threads may be inside it at any time
+	class FCountingMalloc : public FMalloc
+	{
+	public:
+		static FCountingMalloc& Get()
+		{
+			static FCountingMalloc* Instance = []
+			{
+				FCountingMalloc* Counting = new FCountingMalloc(GMalloc);
+				GMalloc = Counting;
+				return Counting;
+			}();
+			return *Instance;
+		}
+
+		bool bCounting = false;
+		uint64 Allocations = 0;
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual const TCHAR* GetDescriptorName() const override { return Inner->GetDescriptorName(); }
+
+	private:
+		explicit FCountingMalloc(FMalloc* Inner) : Inner(Inner) {}
+
+		void CountAllocation()
+		{
+			if (bCounting && IsInGameThread())
+			{
+				Allocations++;
+			}
+		}
+
+		FMalloc* Inner;
+	};
+
+	struct FLuaAllocCounter
+	{
+		lua_Alloc Inner;
+		void* InnerUserdata;
+		uint64 Allocations = 0;
+	};
+
+	// Runs inside lua_pcall. Expects the array wrapper at index 1 and the element count at index 2
+	int RunArrayBenchmark(lua_State* L)
+	{
+		FLuaTArray* Array = FLuaTArray::Get(L, 1);
+		const int Num = luaL_checkinteger(L, 2);
+
+		double Start = FPlatformTime::Seconds();
+		FTIPropertyMarshaller::ArrayToTable(L, Array->ArrayProperty, Array->Value);
+		const double ToTable = NanosecondsPerOp(Start, Num);
+		Start = FPlatformTime::Seconds();
+		FTIPropertyMarshaller::TableToArray(L, Array->ArrayProperty, Array->Value, -1);
+		const double FromTable = NanosecondsPerOp(Start, Num);
+		lua_pop(L, 1);
+
+		double ElementWise[2];
+		const char* Loops[] = {
+			"local a = ... for i = 1, #a do local _ = a[i] end",
+			"local a = ... for i = 1, #a do a[i] = a[i] end",
+		};
+		for (int i = 0; i < 2; i++)
+		{
+			luaL_loadstring(L, Loops[i]);
+			lua_pushvalue(L, 1);
+			Start = FPlatformTime::Seconds();
+			lua_call(L, 1, 0);
+			ElementWise[i] = NanosecondsPerOp(Start, Num);
+		}
+		LOGF("%s: ToTable %.1f ns/element, FromTable %.1f ns/element, a[i] reads %.1f ns/element, a[i] = a[i] %.1f ns/element",
+		     *Array->ArrayProperty->GetName(), ToTable, FromTable, ElementWise[0], ElementWise[1])
+		return 0;
+	}
+
+	int RunQueryBenchmark(lua_State* L)
+	{
+		const char* Queries[] = {
+			"local c = ... return #c:Query('Int', '==', 7)",
+			"local c, n = ..., 0 for _, o in ipairs(c:GetObjects()) do if o.Int == 7 then n = n + 1 end end return n",
+			"local c, n = ..., 0 for o in c:Objects() do if o.Int == 7 then n = n + 1 end end return n",
+		};
+		const TCHAR* Names[] = {TEXT("Query"), TEXT("GetObjects loop"), TEXT("Objects loop")};
+		for (int i = 0; i < 3; i++)
+		{
+			luaL_loadstring(L, Queries[i]);
+			lua_pushvalue(L, 1);
+			const double Start = FPlatformTime::Seconds();
+			lua_call(L, 1, 1);
+			const double Milliseconds = (FPlatformTime::Seconds() - Start) * 1000;
+			LOGF("%s: %lld matches in %.2fms", Names[i], lua_tointeger(L, -1), Milliseconds)
+			lua_pop(L, 1);
+			lua_gc(L, LUA_GCCOLLECT);
+		}
+		return 0;
+	}
+
+	void* CountingLuaAlloc(void* Userdata, void* Block, size_t OldSize, size_t NewSize)
+	{
+		FLuaAllocCounter* Counter = static_cast<FLuaAllocCounter*>(Userdata);
+		// Lua passes the object type instead of a size for new blocks
+		if (NewSize > 0 && (!Block || NewSize > OldSize))
+		{
+			Counter->Allocations++;
+		}
+		return Counter->Inner(Counter->InnerUserdata, Block, OldSize, NewSize);
+	}
+}
+
+void UTweakItTesting::BenchmarkMarshalling(int Iterations)
+{
+	LOGF("Benchmarking marshalling with %d iterations per field", Iterations)
+	FLuaState State;
+	lua_pushcfunction(State.L, RunMarshallingBenchmark);
+	lua_pushinteger(State.L, Iterations);
+	FTILua::CheckLua(State.L, lua_pcall(State.L, 1, 0, 0));
+}
+
+void UTweakItTesting::BenchmarkWrapperAllocations(int Iterations)
+{
+	LOGF("Benchmarking wrapper allocations with %d accesses per field", Iterations)
+	FLuaState State;
+	lua_State* L = State.L;
+	FLuaAllocCounter LuaCounter;
+	LuaCounter.Inner = lua_getallocf(L, &LuaCounter.InnerUserdata);
+	lua_setallocf(L, CountingLuaAlloc, &LuaCounter);
+	FCountingMalloc& EngineCounter = FCountingMalloc::Get();
+	// Lua's collector would count its own work, leave it to the end
+	lua_gc(L, LUA_GCSTOP);
+	FLuaUObject::ConstructObject(L, Get());
+	lua_setglobal(L, "o");
+	for (const char* Field : {"Int", "This", "Item", "Numbers"})
+	{
+		FString Chunk = FString::Printf(TEXT("for i = 1, %d do local _ = o.%s end"), Iterations, UTF8_TO_TCHAR(Field));
+		if (!FTILua::CheckLua(L, luaL_loadstring(L, TCHAR_TO_UTF8(*Chunk))))
+		{
+			return;
+		}
+		LuaCounter.Allocations = 0;
+		EngineCounter.Allocations = 0;
+		EngineCounter.bCounting = true;
+		const bool Ran = FTILua::CheckLua(L, lua_pcall(L, 0, 0, 0));
+		EngineCounter.bCounting = false;
+		if (Ran)
+		{
+			LOGF("o.%s: %.2f Lua allocations, %.2f engine allocations per access", UTF8_TO_TCHAR(Field),
+			     double(LuaCounter.Allocations) / FMath::Max(Iterations, 1),
+			     double(EngineCounter.Allocations) / FMath::Max(Iterations, 1))
+		}
+		lua_gc(L, LUA_GCCOLLECT);
+	}
+}
+
+void UTweakItTesting::BenchmarkArrays(int Num)
+{
+	LOGF("Benchmarking arrays of %d elements", Num)
+	UTweakItTesting* Testing = Get();
+	TArray<int> Numbers = Testing->Numbers;
+	TArray<float> Floats = Testing->Floats;
+	TArray<UObject*> Objects = Testing->Objects;
+	Testing->Numbers.SetNumUninitialized(Num);
+	Testing->Floats.SetNumUninitialized(Num);
+	Testing->Objects.Init(Testing, Num);
+	for (int i = 0; i < Num; i++)
+	{
+		Testing->Numbers[i] = i;
+		Testing->Floats[i] = i * 0.5f;
+	}
+
+	FLuaState State;
+	// Per element logs would be the only thing measured
+	const ELogVerbosity::Type Verbosity = FTILog::Verbosity;
+	FTILog::SetVerbosity(FMath::Min(Verbosity, ELogVerbosity::Log));
+	for (const TCHAR* Name : {TEXT("Numbers"), TEXT("Floats"), TEXT("Objects")})
+	{
+		FArrayProperty* Property = CastField<FArrayProperty>(StaticClass()->FindPropertyByName(Name));
+		lua_pushcfunction(State.L, RunArrayBenchmark);
+		FLuaTArray::ConstructArray(State.L, Property, Property->ContainerPtrToValuePtr<void>(Testing));
+		lua_pushinteger(State.L, Num);
+		FTILua::CheckLua(State.L, lua_pcall(State.L, 2, 0, 0));
+	}
+	FTILog::SetVerbosity(Verbosity);
+
+	Testing->Numbers = Numbers;
+	Testing->Floats = Floats;
+	Testing->Objects = Objects;
+}
+
+void UTweakItTesting::BenchmarkQuery(int Num)
+{
+	LOGF("Benchmarking queries over %d objects", Num)
+	// Per object logs would be the only thing measured
+	const ELogVerbosity::Type Verbosity = FTILog::Verbosity;
+	FTILog::SetVerbosity(FMath::Min(Verbosity, ELogVerbosity::Warning));
+	TArray<UTweakItTesting*> Instances;
+	Instances.Reserve(Num);
+	for (int i = 0; i < Num; i++)
+	{
+		UTweakItTesting* Instance = NewObject<UTweakItTesting>(GetTransientPackage());
+		Instance->Int = i % 100;
+		Instance->AddToRoot();
+		Instances.Add(Instance);
+	}
+	FTILog::SetVerbosity(FMath::Min(Verbosity, ELogVerbosity::Log));
+
+	FLuaState State;
+	lua_pushcfunction(State.L, RunQueryBenchmark);
+	FLuaUClass::ConstructClass(State.L, StaticClass());
+	FTILua::CheckLua(State.L, lua_pcall(State.L, 1, 0, 0));
+	FTILog::SetVerbosity(Verbosity);
+
+	for (UTweakItTesting* Instance : Instances)
+	{
+		Instance->RemoveFromRoot();
+		Instance->MarkPendingKill();
+	}
+}
+
+void UTweakItTesting::BenchmarkSharedState(int Num)
+{
+	LOGF("Benchmarking %d states", Num)
+	const char* Script = "Total = 0 for i = 1, 10 do Total = Total + i end";
+	auto KilobytesOf = [](lua_State* L)
+	{
+		return lua_gc(L, LUA_GCCOUNT) + lua_gc(L, LUA_GCCOUNTB) / 1024.0;
+	};
+
+	TArray<TUniquePtr<FLuaState>> States;
+	double Start = FPlatformTime::Seconds();
+	double Kilobytes = 0;
+	for (int i = 0; i < Num; i++)
+	{
+		FLuaState* State = States.Add_GetRef(MakeUnique<FLuaState>()).Get();
+		luaL_dostring(State->L, Script);
+		lua_gc(State->L, LUA_GCCOLLECT);
+		Kilobytes += KilobytesOf(State->L);
+	}
+	LOGF("Separate states: %.1f KB and %.3fms per state", Kilobytes / FMath::Max(Num, 1),
+	     (FPlatformTime::Seconds() - Start) * 1000 / FMath::Max(Num, 1))
+	States.Empty();
+
+	Start = FPlatformTime::Seconds();
+	FLuaState Shared;
+	const double Base = KilobytesOf(Shared.L);
+	for (int i = 0; i < Num; i++)
+	{
+		FLuaState* State = States.Add_GetRef(MakeUnique<FLuaState>(&Shared)).Get();
+		luaL_loadstring(State->L, Script);
+		State->SetEnvironment(-1);
+		lua_call(State->L, 0, 0);
+	}
+	lua_gc(Shared.L, LUA_GCCOLLECT);
+	LOGF("Shared state: %.1f KB for the state, then %.1f KB and %.3fms per script", Base,
+	     (KilobytesOf(Shared.L) - Base) / FMath::Max(Num, 1), (FPlatformTime::Seconds() - Start) * 1000 / FMath::Max(Num, 1))
+	States.Empty();
+}
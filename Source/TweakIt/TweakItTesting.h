@@ -77,12 +77,39 @@ public:
 	UPROPERTY(EditAnywhere)
 	TArray<int> Numbers = {54, 12, 154};
 
+	UPROPERTY()
+	TArray<float> Floats;
+
+	UPROPERTY()
+	TArray<UObject*> Objects;
+
 	UPROPERTY()
 	TArray<EBuildGunState> states = {EBuildGunState::BGS_MAX, EBuildGunState::BGS_MENU};
 
 	UFUNCTION()
 	static int Testing(ETIEnum EnumP, FString StringP);
 
+	// Logs the ns/op of converting each of this class's fields to and from Lua, and with the CastField chain it replaced
+	UFUNCTION()
+	static void BenchmarkMarshalling(int Iterations);
+
+	// Logs the Lua and engine heap allocations per field access on this class's default object. Lua's pool pages
+	// and large blocks come from the engine heap, so they show in both
+	UFUNCTION()
+	static void BenchmarkWrapperAllocations(int Iterations);
+
+	// Logs the ns/element of converting Numbers, Floats and Objects filled with Num elements, in bulk and element by element
+	UFUNCTION()
+	static void BenchmarkArrays(int Num);
+
+	// Logs how long finding the objects with a given Int takes among Num instances, with Class:Query and with a Lua loop
+	UFUNCTION()
+	static void BenchmarkQuery(int Num);
+
+	// Logs the Lua memory and creation time of Num states, each in its own VM and sharing one
+	UFUNCTION()
+	static void BenchmarkSharedState(int Num);
+
 	UPROPERTY()
 	FTITestingDelegate Delegate;
 